@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#include "arena.h"
+
+using namespace std;
+
+/* ***************** */
+/* REGISTRONOH       */
+/* ***************** */
+
+double RegistroNoh::getG() const
+{
+    return retos + diagonais*sqrt(2.0);
+}
+
+/* ***************** */
+/* CLASSE ARENANOS   */
+/* ***************** */
+
+ArenaNos::ArenaNos(): blocos(), usados(0) {}
+
+/// Descarta todos os registros (mantem os blocos alocados)
+void ArenaNos::reiniciar()
+{
+    usados = 0;
+}
+
+/// Aloca um registro e retorna o seu numero
+bool ArenaNos::alocar(unsigned& num, unsigned maxBlocos)
+{
+    if (usados == blocos.size()*TAM_BLOCO_ARENA)
+    {
+        // Todos os blocos estao cheios
+        if ((maxBlocos > 0 && blocos.size() >= maxBlocos) || usados >= NOH_FECHADO - TAM_BLOCO_ARENA)
+        {
+            return false;
+        }
+        blocos.push_back(unique_ptr<RegistroNoh[]>(new RegistroNoh[TAM_BLOCO_ARENA]));
+    }
+    num = usados++;
+    return true;
+}
+
+/// Acesso a um registro
+RegistroNoh& ArenaNos::operator[](unsigned num)
+{
+    return blocos[num/TAM_BLOCO_ARENA][num%TAM_BLOCO_ARENA];
+}
+
+const RegistroNoh& ArenaNos::operator[](unsigned num) const
+{
+    return blocos[num/TAM_BLOCO_ARENA][num%TAM_BLOCO_ARENA];
+}
+
+unsigned ArenaNos::size() const
+{
+    return usados;
+}
+
+/// Memoria ocupada pelos blocos, em bytes
+size_t ArenaNos::getBytes() const
+{
+    return blocos.size()*TAM_BLOCO_ARENA*sizeof(RegistroNoh);
+}
+
+/* ********************* */
+/* CLASSE CONTEXTOBUSCA  */
+/* ********************* */
+
+ContextoBusca::ContextoBusca(size_t limite): nos(), aberto(), registro(), limiteBytes(limite),
+    bytesConsulta(0), picoBytes(0) {}
+
+/// Prepara o contexto para uma consulta
+bool ContextoBusca::iniciar(unsigned numIndices)
+{
+    nos.reiniciar();
+    aberto.clear();
+    bytesConsulta = 0;
+    if (limiteBytes > 0 && size_t(numIndices)*sizeof(unsigned) > limiteBytes)
+    {
+        return false;
+    }
+    // A tabela soh cresce (os valores antigos nao precisam ser apagados)
+    if (registro.size() < numIndices) registro.resize(numIndices);
+    return true;
+}
+
+/// Termina a consulta, atualizando a memoria usada
+void ContextoBusca::terminar()
+{
+    bytesConsulta = getBytes();
+    picoBytes = max(picoBytes, bytesConsulta);
+}
+
+/// Gera um noh para a celula cel e o coloca na fila
+bool ContextoBusca::gerar(unsigned cel, unsigned pai, unsigned retos, unsigned diagonais, double f)
+{
+    // Crescimento da fila: feito aqui para que o limite seja respeitado
+    if (aberto.size() == aberto.capacity())
+    {
+        size_t novaCap = max(size_t(TAM_BLOCO_ARENA), 2*aberto.capacity());
+        if (limiteBytes > 0 && getBytes() + (novaCap-aberto.capacity())*sizeof(Entrada) > limiteBytes)
+        {
+            return false;
+        }
+        aberto.reserve(novaCap);
+    }
+
+    unsigned maxBlocos = 0;
+    if (limiteBytes > 0)
+    {
+        size_t outros = getBytes() - nos.getBytes();
+        if (outros >= limiteBytes) return false;
+        maxBlocos = max<size_t>(1, (limiteBytes-outros)/(TAM_BLOCO_ARENA*sizeof(RegistroNoh)));
+    }
+    unsigned num;
+    if (!nos.alocar(num, maxBlocos)) return false;
+
+    RegistroNoh& R = nos[num];
+    R.cel = cel;
+    R.pai = pai;
+    R.retos = retos;
+    R.diagonais = diagonais;
+    registro[cel] = num;
+
+    aberto.push_back(Entrada(f, num));
+    push_heap(aberto.begin(), aberto.end(), greater<Entrada>());
+    return true;
+}
+
+/// Retira da fila o noh aberto de menor custo
+bool ContextoBusca::retirar(unsigned& num)
+{
+    while (!aberto.empty())
+    {
+        pop_heap(aberto.begin(), aberto.end(), greater<Entrada>());
+        num = aberto.back().second;
+        aberto.pop_back();
+        // Descarta registros substituidos (a celula foi gerada de novo com custo menor)
+        // e registros jah fechados
+        if (registro[nos[num].cel] == num && !(nos[num].pai & NOH_FECHADO)) return true;
+    }
+    return false;
+}
+
+/// Retorna o registro corrente da celula cel
+const RegistroNoh* ContextoBusca::corrente(unsigned cel) const
+{
+    unsigned num = registro[cel];
+    if (num < nos.size() && nos[num].cel == cel) return &nos[num];
+    return nullptr;
+}
+
+/// Marca o registro num como fechado
+void ContextoBusca::fechar(unsigned num)
+{
+    nos[num].pai |= NOH_FECHADO;
+}
+
+/// Acesso aos registros da consulta atual
+const RegistroNoh& ContextoBusca::operator[](unsigned num) const
+{
+    return nos[num];
+}
+
+unsigned ContextoBusca::getNumRegistros() const
+{
+    return nos.size();
+}
+
+/// Memoria em uso, em bytes
+size_t ContextoBusca::getBytes() const
+{
+    return nos.getBytes() + aberto.capacity()*sizeof(Entrada) + registro.size()*sizeof(unsigned);
+}
+
+size_t ContextoBusca::getBytesConsulta() const
+{
+    return bytesConsulta;
+}
+
+size_t ContextoBusca::getPicoBytes() const
+{
+    return picoBytes;
+}
+
+size_t ContextoBusca::getLimiteBytes() const
+{
+    return limiteBytes;
+}
@@ -0,0 +1,121 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+using namespace std;
+
+/// Numero de registros em cada bloco da arena (64 KB por bloco)
+#define TAM_BLOCO_ARENA 4096
+
+/// Limite padrao de memoria de uma consulta, em bytes (0 = sem limite)
+#define LIMITE_MEMORIA_BUSCA (size_t(1) << 30)
+
+/// Marca, no campo "pai", de um registro cujo noh jah foi fechado (expandido)
+#define NOH_FECHADO 0x80000000u
+
+/// Um noh gerado pela busca A*, em 16 bytes
+/// O custo g eh guardado exatamente, como numero de passos retos e diagonais:
+/// g = retos + diagonais*sqrt(2)
+struct RegistroNoh
+{
+    /// Indice da celula no vetor do mapa
+    unsigned cel;
+    /// Registro do noh pai (o proprio registro na origem), mais a marca NOH_FECHADO
+    unsigned pai;
+    unsigned retos, diagonais;
+
+    double getG() const;
+};
+
+/// Arena monotonica de registros de nos
+/// Os registros sao alocados em blocos de TAM_BLOCO_ARENA, que nunca mudam de lugar
+/// nem sao liberados entre consultas: depois das primeiras consultas, gerar um noh
+/// nao faz nenhuma alocacao
+class ArenaNos
+{
+private:
+    vector<unique_ptr<RegistroNoh[]> > blocos;
+    /// Numero de registros em uso na consulta atual
+    unsigned usados;
+
+public:
+    ArenaNos();
+
+    /// Descarta todos os registros (mantem os blocos alocados)
+    void reiniciar();
+    /// Aloca um registro e retorna o seu numero
+    /// Retorna false se for preciso um novo bloco e isso ultrapassar maxBlocos (0 = sem limite)
+    bool alocar(unsigned& num, unsigned maxBlocos=0);
+
+    /// Acesso a um registro (sem teste de limites)
+    RegistroNoh& operator[](unsigned num);
+    const RegistroNoh& operator[](unsigned num) const;
+
+    unsigned size() const;
+    /// Memoria ocupada pelos blocos, em bytes
+    size_t getBytes() const;
+};
+
+/// Contexto de uma busca A* (Labirinto::buscaCaminho)
+/// Contem toda a memoria usada pela busca: a arena de nos, a fila de prioridade e a
+/// tabela celula -> registro; reusar um contexto em varias consultas evita as alocacoes
+/// A memoria de cada consulta eh limitada a limiteBytes: se for ultrapassado, a busca
+/// retorna COMPR_SEM_MEMORIA
+/// Um contexto soh pode ser usado por uma busca de cada vez (um por thread)
+class ContextoBusca
+{
+public:
+    /// Entrada da fila de prioridade: (custo f, registro)
+    typedef pair<double,unsigned> Entrada;
+
+private:
+    ArenaNos nos;
+    /// Heap (menor custo primeiro) das entradas em aberto
+    /// Entradas de registros substituidos sao descartadas ao sair da fila
+    vector<Entrada> aberto;
+    /// Celula -> ultimo registro gerado para ela
+    /// Nao eh reiniciada entre consultas: a entrada soh vale se apontar para um registro
+    /// da consulta atual que seja da mesma celula
+    vector<unsigned> registro;
+    size_t limiteBytes;
+    /// Memoria da ultima consulta e maior memoria entre todas as consultas
+    size_t bytesConsulta, picoBytes;
+
+public:
+    explicit ContextoBusca(size_t limite=LIMITE_MEMORIA_BUSCA);
+
+    /// Prepara o contexto para uma consulta em um mapa com numIndices celulas
+    /// Retorna false se a tabela de celulas sozinha ultrapassar o limite
+    bool iniciar(unsigned numIndices);
+    /// Termina a consulta, atualizando a memoria usada
+    void terminar();
+
+    /// Gera um noh para a celula cel (que passa a ser o registro corrente dela)
+    /// e o coloca na fila com custo f
+    /// Retorna false se o limite de memoria for ultrapassado
+    bool gerar(unsigned cel, unsigned pai, unsigned retos, unsigned diagonais, double f);
+    /// Retira da fila o noh aberto de menor custo, descartando os substituidos
+    /// Retorna false se nao houver mais nos em aberto
+    bool retirar(unsigned& num);
+    /// Retorna o registro corrente da celula cel (nullptr se ela nao foi gerada)
+    const RegistroNoh* corrente(unsigned cel) const;
+    /// Marca o registro num como fechado
+    void fechar(unsigned num);
+
+    /// Acesso aos registros da consulta atual
+    const RegistroNoh& operator[](unsigned num) const;
+    unsigned getNumRegistros() const;
+
+    /// Memoria em uso, em bytes (arena + fila + tabela de celulas)
+    size_t getBytes() const;
+    /// Memoria usada pela ultima consulta
+    size_t getBytesConsulta() const;
+    /// Maior memoria usada por uma consulta desde a criacao do contexto
+    size_t getPicoBytes() const;
+    size_t getLimiteBytes() const;
+};
+
+#endif // _ARENA_H_
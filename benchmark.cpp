@@ -0,0 +1,353 @@
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include "benchmark.h"
+
+using namespace std;
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Testa se a celula de indice idx (coordenadas C) pode mover na direcao (dl,dc)
+/// Mesmas regras de movimentoValido, mas usando somente indices
+static bool movimentoValidoIdx(const Labirinto& L, unsigned idx, const Coord& C, int dl, int dc)
+{
+    if (!L.coordValida(Coord(C.lin+dl, C.col+dc))) return false;
+    if (L.atIndice(L.indiceVizinho(idx,dl,dc)) == EstadoCel::OBSTACULO) return false;
+    if (L.atIndice(L.indiceVizinho(idx,dl,0)) == EstadoCel::OBSTACULO) return false;
+    if (L.atIndice(L.indiceVizinho(idx,0,dc)) == EstadoCel::OBSTACULO) return false;
+    return true;
+}
+
+/// Varre todas as celulas livres e conta os movimentos validos a partir delas
+static unsigned long varredura(const Labirinto& L)
+{
+    unsigned long cont = 0;
+    for (unsigned i=0; i<L.getNumLin(); i++) for (unsigned j=0; j<L.getNumCol(); j++)
+        {
+            unsigned idx = L.indice(i,j);
+            if (L.atIndice(idx) == EstadoCel::OBSTACULO) continue;
+            for (int dl=-1; dl<2; dl++) for (int dc=-1; dc<2; dc++)
+                {
+                    if ((dl!=0 || dc!=0) && movimentoValidoIdx(L, idx, Coord(i,j), dl, dc)) cont++;
+                }
+        }
+    return cont;
+}
+
+/// Passeio aleatorio: a cada passo, tenta mover para uma das 8 vizinhas
+/// As direcoes sorteadas sao as mesmas para todos os layouts
+static unsigned long passeio(const Labirinto& L, const Coord& inicio,
+                             const vector<unsigned char>& direcoes)
+{
+    Coord C = inicio;
+    unsigned idx = L.indice(C);
+    unsigned long cont = 0;
+    for (unsigned char d : direcoes)
+    {
+        int dl = int(d/3)-1, dc = int(d%3)-1;
+        if ((dl!=0 || dc!=0) && movimentoValidoIdx(L, idx, C, dl, dc))
+        {
+            idx = L.indiceVizinho(idx, dl, dc);
+            C = C + Coord(dl,dc);
+            cont++;
+        }
+    }
+    return cont;
+}
+
+/// Testa se De eh alcancavel a partir de Or sem sair do quadrado de raio "raio" em torno de Or
+/// Garante que as consultas curtas nao exploram o mapa inteiro (caso de destino inalcancavel)
+static bool alcancavelLocal(const Labirinto& L, const Coord& Or, const Coord& De, int raio)
+{
+    int lado = 2*raio+1;
+    vector<bool> visitado(lado*lado, false);
+    vector<Coord> pilha(1, Or);
+    visitado[raio*lado+raio] = true;
+    while (!pilha.empty())
+    {
+        Coord C = pilha.back();
+        pilha.pop_back();
+        if (C == De) return true;
+        for (int dl=-1; dl<2; dl++) for (int dc=-1; dc<2; dc++)
+            {
+                Coord V = C + Coord(dl,dc);
+                Coord D = V - Or + Coord(raio,raio);
+                if (D.lin<0 || D.col<0 || D.lin>=lado || D.col>=lado) continue;
+                if (visitado[D.lin*lado+D.col] || !L.movimentoValido(C, V)) continue;
+                visitado[D.lin*lado+D.col] = true;
+                pilha.push_back(V);
+            }
+    }
+    return false;
+}
+
+/// Compara o desempenho dos layouts de celulas em um mapa aleatorio
+void benchLayouts(ostream& O, unsigned numL, unsigned numC, double perc_obst,
+                  unsigned numPassos, unsigned numConsultas)
+{
+    Labirinto base;
+    if (!base.gerar(numL, numC, perc_obst))
+    {
+        O << "Parametros invalidos para a geracao do mapa\n";
+        return;
+    }
+
+    // Sorteia (com semente fixa) os dados usados por todos os layouts
+    srand(1);
+    vector<unsigned char> direcoes(numPassos);
+    for (unsigned char& d : direcoes) d = rand()%9;
+
+    Coord inicio;
+    do inicio = Coord(rand()%numL, rand()%numC);
+    while (!base.celulaLivre(inicio));
+
+    // Consultas curtas: destino a no maximo 16 casas da origem e alcancavel por perto
+    vector<Coord> origens, destinos;
+    while (origens.size() < numConsultas)
+    {
+        Coord Or(rand()%numL, rand()%numC);
+        Coord De = Or + Coord(rand()%33, rand()%33) - Coord(16,16);
+        if (Or != De && base.celulaLivre(Or) && base.celulaLivre(De) &&
+                alcancavelLocal(base, Or, De, 24))
+        {
+            origens.push_back(Or);
+            destinos.push_back(De);
+        }
+    }
+
+    O << "MAPA " << numL << 'x' << numC << " obst=" << perc_obst << endl;
+    O << setw(8) << "LAYOUT"
+      << setw(16) << "varredura(ms)"
+      << setw(16) << "passeio(ms)"
+      << setw(16) << "consultas(ms)"
+      << setw(12) << "movimentos"
+      << setw(12) << "soma compr"
+      << endl;
+
+    LayoutMapa layouts[] = {LayoutMapa::LINHAS, LayoutMapa::MORTON, LayoutMapa::BLOCOS};
+    for (LayoutMapa lay : layouts)
+    {
+        Labirinto L(base);
+        L.setLayout(lay);
+
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        unsigned long mov = varredura(L);
+        double tVarr = milissegundos(t1);
+
+        t1 = chrono::steady_clock::now();
+        mov += passeio(L, inicio, direcoes);
+        double tPass = milissegundos(t1);
+
+        double soma = 0.0;
+        int NC, NA, NF;
+        t1 = chrono::steady_clock::now();
+        for (unsigned k=0; k<origens.size(); k++)
+        {
+            L.setOrigem(origens[k]);
+            L.setDestino(destinos[k]);
+            double compr = L.calculaCaminho(NC, NA, NF);
+            if (compr > 0.0) soma += compr;
+        }
+        double tCons = milissegundos(t1);
+
+        // "movimentos" e "soma compr" devem ser iguais para todos os layouts
+        O << setw(8) << layout2string(lay)
+          << fixed << setprecision(2)
+          << setw(16) << tVarr
+          << setw(16) << tPass
+          << setw(16) << tCons
+          << setw(12) << mov
+          << setw(12) << soma
+          << endl;
+    }
+}
+
+/// Mede as consultas com contextos de busca novos e com um contexto reusado
+void benchMemoria(ostream& O, unsigned numL, unsigned numC, double perc_obst,
+                  unsigned numConsultas, size_t limiteBytes)
+{
+    Labirinto L;
+    if (!L.gerar(numL, numC, perc_obst))
+    {
+        O << "Parametros invalidos para a geracao do mapa\n";
+        return;
+    }
+
+    // Sorteia (com semente fixa) as consultas entre celulas livres
+    srand(1);
+    vector<Coord> origens, destinos;
+    while (origens.size() < numConsultas)
+    {
+        Coord Or(rand()%numL, rand()%numC), De(rand()%numL, rand()%numC);
+        if (L.celulaLivre(Or) && L.celulaLivre(De))
+        {
+            origens.push_back(Or);
+            destinos.push_back(De);
+        }
+    }
+
+    vector<Coord> pontos;
+    vector<double> compr(numConsultas);
+    int NA, NF;
+
+    // Um contexto novo (alocado e liberado) a cada consulta
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    for (unsigned k=0; k<numConsultas; k++)
+    {
+        compr[k] = L.buscaCaminho(origens[k], destinos[k], pontos, NA, NF);
+    }
+    double tNovo = milissegundos(t1);
+
+    // Um unico contexto, reusado
+    ContextoBusca ctx(limiteBytes);
+    size_t somaBytes = 0;
+    unsigned excedidas = 0, diferencas = 0;
+    t1 = chrono::steady_clock::now();
+    for (unsigned k=0; k<numConsultas; k++)
+    {
+        double c = L.buscaCaminho(origens[k], destinos[k], pontos, NA, NF, nullptr, &ctx);
+        somaBytes += ctx.getBytesConsulta();
+        if (c == COMPR_SEM_MEMORIA) excedidas++;
+        else if (fabs(c - compr[k]) > 1e-6) diferencas++;
+    }
+    double tReuso = milissegundos(t1);
+
+    O << "MAPA " << numL << 'x' << numC << " obst=" << perc_obst << "\t "
+      << numConsultas << " consultas\t registro=" << sizeof(RegistroNoh) << " bytes" << endl;
+    O << fixed << setprecision(3)
+      << "Contexto novo por consulta: " << tNovo << "ms" << endl
+      << "Contexto reusado: " << tReuso << "ms\t Memoria media="
+      << somaBytes/1024.0/max(numConsultas, 1u) << "KB\t Pico=" << ctx.getPicoBytes()/1024.0
+      << "KB\t Limite=" << limiteBytes/1024.0 << "KB" << endl
+      << "Acima do limite=" << excedidas << "\t Diferencas=" << diferencas << endl;
+}
+
+/// Compara a busca pelo destino mais proximo com buscas separadas
+void benchMaisProximo(ostream& O, unsigned numL, unsigned numC, double perc_obst,
+                      unsigned numAlvos, unsigned numConsultas)
+{
+    Labirinto L;
+    if (!L.gerar(numL, numC, perc_obst) || numAlvos == 0)
+    {
+        O << "Parametros invalidos para a geracao do mapa\n";
+        return;
+    }
+
+    // Sorteia (com semente fixa) uma celula livre
+    srand(1);
+    auto sorteia = [&L, numL, numC]() -> Coord
+    {
+        Coord C;
+        do C = Coord(rand()%numL, rand()%numC);
+        while (!L.celulaLivre(C));
+        return C;
+    };
+
+    ContextoBusca ctx;
+    vector<Coord> pontos;
+    int NA, NF, alvo;
+    double tUnica = 0.0, tSeparadas = 0.0;
+    unsigned long fechUnica = 0, fechSeparadas = 0;
+    unsigned diferencas = 0;
+    for (unsigned k=0; k<numConsultas; k++)
+    {
+        Coord Or = sorteia();
+        vector<Coord> destinos;
+        for (unsigned d=0; d<numAlvos; d++) destinos.push_back(sorteia());
+
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        double c1 = L.buscaMaisProximo(vector<Coord>(1, Or), destinos, pontos, alvo, NA, NF,
+                                       nullptr, &ctx);
+        tUnica += milissegundos(t1);
+        fechUnica += NF;
+
+        double c2 = -1.0;
+        t1 = chrono::steady_clock::now();
+        for (const Coord& De : destinos)
+        {
+            double c = L.buscaCaminho(Or, De, pontos, NA, NF, nullptr, &ctx);
+            if (c >= 0.0 && (c2 < 0.0 || c < c2)) c2 = c;
+            fechSeparadas += NF;
+        }
+        tSeparadas += milissegundos(t1);
+
+        if (fabs(c1-c2) > 1e-6) diferencas++;
+    }
+
+    O << "MAPA " << numL << 'x' << numC << " obst=" << perc_obst << "\t " << numConsultas
+      << " consultas com " << numAlvos << " destinos ("
+      << (numAlvos <= MAX_ALVOS_HEURISTICA ? "A*" : "Dijkstra") << ")" << endl;
+    O << fixed << setprecision(3)
+      << "Busca unica: " << tUnica << "ms\t Fechados=" << fechUnica << endl
+      << "Buscas separadas: " << tSeparadas << "ms\t Fechados=" << fechSeparadas << endl
+      << "Aceleracao=" << tSeparadas/max(tUnica, 1e-9) << "x\t Diferencas=" << diferencas << endl;
+}
+
+/// Compara a leitura completa do mapa com a leitura de janelas em torno das consultas
+void benchJanela(ostream& O, const string& nome_arq, unsigned numConsultas,
+                 unsigned distMax, unsigned margem)
+{
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    Labirinto M;
+    if (!M.ler(nome_arq, Janela(0, 0, Labirinto::getAlturaMax(), Labirinto::getLarguraMax())))
+    {
+        O << "Erro na leitura do arquivo " << nome_arq << endl;
+        return;
+    }
+    double tLeitura = milissegundos(t1);
+
+    // Consultas curtas sorteadas (com semente fixa)
+    srand(1);
+    vector<Coord> origens, destinos;
+    for (unsigned tentativas=0; origens.size() < numConsultas && tentativas < 1000*numConsultas; tentativas++)
+    {
+        Coord Or(rand()%M.getNumLin(), rand()%M.getNumCol());
+        Coord De = Or + Coord(rand()%(2*distMax+1), rand()%(2*distMax+1)) - Coord(distMax, distMax);
+        if (M.celulaLivre(Or) && M.celulaLivre(De))
+        {
+            origens.push_back(Or);
+            destinos.push_back(De);
+        }
+    }
+
+    double tCompleto = 0.0, tJanela = 0.0;
+    unsigned long celulas = 0;
+    unsigned leituras = 0, diferencas = 0;
+    vector<Coord> pontos;
+    for (unsigned k=0; k<origens.size(); k++)
+    {
+        int NA, NF, numLeituras;
+        t1 = chrono::steady_clock::now();
+        double c1 = M.buscaCaminho(origens[k], destinos[k], pontos, NA, NF);
+        tCompleto += milissegundos(t1);
+
+        Labirinto J;
+        t1 = chrono::steady_clock::now();
+        double c2 = J.buscaComJanela(nome_arq, origens[k], destinos[k], pontos, margem, &numLeituras);
+        tJanela += milissegundos(t1);
+        celulas += (unsigned long)J.getNumLin()*J.getNumCol();
+        leituras += numLeituras;
+
+        bool valido = (c2 < 0.0 || (pontos.front() == origens[k] && pontos.back() == destinos[k]));
+        for (unsigned p=1; valido && p<pontos.size(); p++) valido = M.movimentoValido(pontos[p-1], pontos[p]);
+        if (fabs(c1-c2) > 1e-6 || !valido) diferencas++;
+    }
+
+    unsigned n = max(unsigned(origens.size()), 1u);
+    O << "JANELA " << nome_arq << ' ' << M.getNumLin() << 'x' << M.getNumCol() << ", "
+      << origens.size() << " consultas (distancia ate " << distMax << ", margem " << margem << ")" << endl;
+    O << fixed << setprecision(3)
+      << "Mapa completo: leitura=" << tLeitura << "ms\t busca=" << tCompleto/n << "ms/consulta\t Celulas="
+      << (unsigned long)M.getNumLin()*M.getNumCol() << endl
+      << "Janela: leitura+busca=" << tJanela/n << "ms/consulta\t Celulas=" << celulas/n
+      << "\t Leituras=" << double(leituras)/n << endl
+      << "Diferencas=" << diferencas << endl;
+}
@@ -0,0 +1,40 @@
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <iostream>
+#include "labirinto.h"
+#include "arena.h"
+
+/// Compara o desempenho dos layouts de celulas (LINHAS, MORTON e BLOCOS)
+/// em um mapa aleatorio de dimensoes numL x numC, com perc_obst de obstaculos
+/// Para cada layout, mede:
+/// - a varredura de todos os movimentos validos usando indiceVizinho;
+/// - um passeio aleatorio de numPassos passos (acessos dependentes entre si);
+/// - numConsultas consultas curtas com calculaCaminho.
+/// Os resultados sao escritos em O
+void benchLayouts(std::ostream& O, unsigned numL, unsigned numC, double perc_obst,
+                  unsigned numPassos=10000000, unsigned numConsultas=50);
+
+/// Mede numConsultas consultas aleatorias com buscaCaminho em um mapa aleatorio numL x numC:
+/// primeiro com um contexto de busca novo a cada consulta, depois com um unico contexto
+/// reusado, limitado a limiteBytes
+/// Escreve em O os tempos, a memoria por consulta (media e pico) e quantas consultas
+/// ultrapassaram o limite
+void benchMemoria(std::ostream& O, unsigned numL, unsigned numC, double perc_obst,
+                  unsigned numConsultas=100, size_t limiteBytes=LIMITE_MEMORIA_BUSCA);
+
+/// Compara, em numConsultas consultas em um mapa aleatorio numL x numC, a busca pelo mais
+/// proximo de numAlvos destinos sorteados (buscaMaisProximo) com numAlvos buscas separadas
+/// (buscaCaminho), das quais se toma a menor
+/// Escreve em O os tempos, os nos fechados e o numero de comprimentos divergentes
+void benchMaisProximo(std::ostream& O, unsigned numL, unsigned numC, double perc_obst,
+                      unsigned numAlvos=10, unsigned numConsultas=20);
+
+/// Compara, em numConsultas consultas curtas (destino a no maximo distMax casas da origem)
+/// no mapa do arquivo nome_arq, a leitura completa do mapa com a leitura de janelas em
+/// torno das consultas (buscaComJanela, com a margem inicial dada)
+/// Escreve em O os tempos, o numero de celulas lidas e o numero de comprimentos divergentes
+void benchJanela(std::ostream& O, const string& nome_arq, unsigned numConsultas=20,
+                 unsigned distMax=50, unsigned margem=32);
+
+#endif // _BENCHMARK_H_
@@ -0,0 +1,33 @@
+#ifndef _BINARIO_H_
+#define _BINARIO_H_
+
+#include <cstdint>
+
+/// Funcoes auxiliares das codificacoes binarias (codificacao compacta do mapa, serializacao
+/// de caminhos e indice da hierarquia de contracao)
+/// Os inteiros sao gravados em little-endian, qualquer que seja a plataforma
+
+/// Escreve / leh um inteiro de 32 bits (little-endian)
+inline void escreveU32(unsigned char* p, unsigned x)
+{
+    for (int k=0; k<4; k++) p[k] = (x >> (8*k)) & 0xFF;
+}
+
+inline unsigned leU32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (unsigned(p[3]) << 24);
+}
+
+/// Escreve / leh um inteiro de 64 bits (little-endian)
+inline void escreveU64(unsigned char* p, uint64_t x)
+{
+    escreveU32(p, unsigned(x & 0xFFFFFFFF));
+    escreveU32(p+4, unsigned(x >> 32));
+}
+
+inline uint64_t leU64(const unsigned char* p)
+{
+    return leU32(p) | (uint64_t(leU32(p+4)) << 32);
+}
+
+#endif // _BINARIO_H_
@@ -0,0 +1,770 @@
+#include <fstream>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+
+#include "contracao.h"
+#include "binario.h"
+
+using namespace std;
+
+/// Numero maximo de nos fixados em cada busca de testemunhas durante a construcao
+/// Se o limite for atingido, o atalho eh criado (pode sobrar atalho, mas nunca faltar)
+#define LIMITE_TESTEMUNHA 200
+/// Tolerancia na comparacao de comprimentos
+#define EPS_CH 1e-9
+/// Marca do formato do arquivo da hierarquia e tamanhos (em bytes) do cabecalho e de
+/// cada aresta no arquivo
+#define MARCA_CH "LABCH002"
+#define TAM_CABEC_CH 36
+#define TAM_ARESTA_CH 16
+
+/* ********************************* */
+/* CONSTRUCAO (FUNCOES AUXILIARES)   */
+/* ********************************* */
+
+typedef pair<double,unsigned> EntradaCH;
+
+/// Uma aresta do grafo de trabalho da construcao
+/// "passos" eh o numero de movimentos do mapa que a aresta representa
+struct ArestaTrabalho
+{
+    unsigned para;
+    int meio;
+    double peso;
+    unsigned passos;
+};
+
+/// Um atalho a ser criado entre os nos u e w
+struct AtalhoCH
+{
+    unsigned u, w;
+    double peso;
+    unsigned passos;
+};
+
+/// Estado da construcao: o grafo de trabalho e a memoria das buscas de testemunhas
+struct ConstrucaoCH
+{
+    /// Arestas (nos dois sentidos) entre os nos ainda nao contraidos
+    vector<vector<ArestaTrabalho> > adj;
+    /// Arestas de cada noh contraido para os vizinhos que ainda nao estavam contraidos
+    /// (todos de nivel maior): sao as arestas do grafo de busca
+    vector<vector<ArestaCH> > subida;
+    vector<bool> contraido;
+    /// Distancias da busca de testemunhas e nos alcancados (para limpar)
+    vector<double> dist;
+    vector<unsigned> tocados;
+    /// Heap (menor distancia primeiro) da busca de testemunhas, reusado entre as buscas
+    vector<EntradaCH> heap;
+    /// Alvos da busca de testemunhas atual: os nos com marca igual a "busca"
+    vector<unsigned> alvo;
+    unsigned busca;
+
+    explicit ConstrucaoCH(unsigned N):
+        adj(N), subida(N), contraido(N, false), dist(N, numeric_limits<double>::infinity()),
+        tocados(), heap(), alvo(N, 0), busca(0) {}
+
+    /// Inicia uma busca de testemunhas (os alvos da busca anterior deixam de valer)
+    void novaBusca()
+    {
+        if (++busca == 0)
+        {
+            // O contador deu a volta: as marcas antigas poderiam parecer atuais
+            fill(alvo.begin(), alvo.end(), 0);
+            busca = 1;
+        }
+    }
+
+    /// Acrescenta ou encurta a aresta u->w
+    void liga(unsigned u, unsigned w, double peso, int meio, unsigned passos)
+    {
+        for (ArestaTrabalho& A : adj[u])
+        {
+            if (A.para == w)
+            {
+                if (peso < A.peso)
+                {
+                    A.peso = peso;
+                    A.meio = meio;
+                    A.passos = passos;
+                }
+                return;
+            }
+        }
+        ArestaTrabalho A = {w, meio, peso, passos};
+        adj[u].push_back(A);
+    }
+
+    /// Calcula os atalhos necessarios para contrair v
+    /// Para cada vizinho u, uma busca limitada (sem passar por v) procura caminhos
+    /// testemunha para os demais vizinhos w; sem testemunha, u-v-w vira atalho
+    void atalhos(unsigned v, vector<AtalhoCH>& saida)
+    {
+        saida.clear();
+        const vector<ArestaTrabalho>& viz = adj[v];
+
+        for (unsigned a=0; a+1<viz.size(); a++)
+        {
+            unsigned u = viz[a].para;
+            double maxVia = 0.0;
+            novaBusca();
+            for (unsigned b=a+1; b<viz.size(); b++)
+            {
+                maxVia = max(maxVia, viz[a].peso + viz[b].peso);
+                alvo[viz[b].para] = busca;
+            }
+            unsigned restantes = viz.size()-a-1;
+
+            // Dijkstra limitado a partir de u, sem passar por v
+            // (termina quando todos os alvos forem fixados)
+            dist[u] = 0.0;
+            tocados.push_back(u);
+            heap.assign(1, EntradaCH(0.0, u));
+            unsigned fixados = 0;
+            while (!heap.empty() && fixados < LIMITE_TESTEMUNHA)
+            {
+                pop_heap(heap.begin(), heap.end(), greater<EntradaCH>());
+                EntradaCH E = heap.back();
+                heap.pop_back();
+                if (E.first > dist[E.second]) continue;
+                if (E.first > maxVia) break;
+                fixados++;
+                if (alvo[E.second] == busca && --restantes == 0) break;
+                for (const ArestaTrabalho& A : adj[E.second])
+                {
+                    if (A.para == v) continue;
+                    double d = E.first + A.peso;
+                    if (d < dist[A.para])
+                    {
+                        if (dist[A.para] == numeric_limits<double>::infinity()) tocados.push_back(A.para);
+                        dist[A.para] = d;
+                        heap.push_back(EntradaCH(d, A.para));
+                        push_heap(heap.begin(), heap.end(), greater<EntradaCH>());
+                    }
+                }
+            }
+
+            for (unsigned b=a+1; b<viz.size(); b++)
+            {
+                double via = viz[a].peso + viz[b].peso;
+                if (dist[viz[b].para] > via + EPS_CH)
+                {
+                    AtalhoCH S = {u, viz[b].para, via, viz[a].passos + viz[b].passos};
+                    saida.push_back(S);
+                }
+            }
+
+            for (unsigned k : tocados) dist[k] = numeric_limits<double>::infinity();
+            tocados.clear();
+        }
+    }
+
+    /// Estima o numero de atalhos (e a soma dos seus passos) necessarios para contrair v,
+    /// procurando somente testemunhas de no maximo 2 arestas (sem busca nem heap)
+    /// Pode superestimar os atalhos; eh usada somente nas prioridades de contracao
+    void estimaAtalhos(unsigned v, unsigned& num, unsigned& passos)
+    {
+        num = passos = 0;
+        const vector<ArestaTrabalho>& viz = adj[v];
+        for (unsigned a=0; a+1<viz.size(); a++)
+        {
+            unsigned u = viz[a].para;
+            // Distancias de 1 aresta a partir de u (sem passar por v)
+            novaBusca();
+            for (const ArestaTrabalho& A : adj[u])
+            {
+                if (A.para == v) continue;
+                alvo[A.para] = busca;
+                dist[A.para] = A.peso;
+                tocados.push_back(A.para);
+            }
+            for (unsigned b=a+1; b<viz.size(); b++)
+            {
+                unsigned w = viz[b].para;
+                double via = viz[a].peso + viz[b].peso;
+                bool testemunha = (alvo[w] == busca && dist[w] <= via + EPS_CH);
+                for (unsigned k=0; !testemunha && k<adj[w].size(); k++)
+                {
+                    const ArestaTrabalho& A = adj[w][k];
+                    testemunha = A.para != v && alvo[A.para] == busca && dist[A.para] + A.peso <= via + EPS_CH;
+                }
+                if (!testemunha)
+                {
+                    num++;
+                    passos += viz[a].passos + viz[b].passos;
+                }
+            }
+            for (unsigned k : tocados) dist[k] = numeric_limits<double>::infinity();
+            tocados.clear();
+        }
+    }
+
+    /// Contrai v: cria os atalhos S e move as arestas de v para o grafo de busca
+    void contrai(unsigned v, const vector<AtalhoCH>& S)
+    {
+        for (const AtalhoCH& A : S)
+        {
+            liga(A.u, A.w, A.peso, v, A.passos);
+            liga(A.w, A.u, A.peso, v, A.passos);
+        }
+        for (const ArestaTrabalho& A : adj[v])
+        {
+            ArestaCH B = {A.para, A.meio, A.peso};
+            subida[v].push_back(B);
+            // Retira a aresta de volta (A.para -> v) do grafo de trabalho
+            vector<ArestaTrabalho>& viz = adj[A.para];
+            for (unsigned k=0; k<viz.size(); k++)
+            {
+                if (viz[k].para == v)
+                {
+                    viz[k] = viz.back();
+                    viz.pop_back();
+                    break;
+                }
+            }
+        }
+        vector<ArestaTrabalho>().swap(adj[v]);
+        contraido[v] = true;
+    }
+};
+
+/* ******************************* */
+/* CLASSE HIERARQUIACONTRACAO      */
+/* ******************************* */
+
+HierarquiaContracao::HierarquiaContracao(): NL(0), NC(0), assinatura(0), noh(), celula(),
+    inicio(), arestas(), numAtalhos(0) {}
+
+/// Assinatura dos obstaculos de um mapa (FNV-1a das dimensoes e das celulas)
+uint64_t HierarquiaContracao::assinaturaMapa(const Labirinto& L)
+{
+    uint64_t h = 14695981039346656037ull;
+    auto mistura = [&h](unsigned x)
+    {
+        h ^= x;
+        h *= 1099511628211ull;
+    };
+    mistura(L.getNumLin());
+    mistura(L.getNumCol());
+    for (unsigned i=0; i<L.getNumLin(); i++) for (unsigned j=0; j<L.getNumCol(); j++)
+        {
+            mistura(L.celulaLivre(Coord(i,j)) ? 1 : 0);
+        }
+    return h;
+}
+
+/// Constroi a hierarquia para o mapa L
+bool HierarquiaContracao::construir(const Labirinto& L)
+{
+    *this = HierarquiaContracao();
+    if (L.empty()) return false;
+
+    NL = L.getNumLin();
+    NC = L.getNumCol();
+    assinatura = assinaturaMapa(L);
+
+    // Numera as celulas livres
+    noh.assign(NL*NC, -1);
+    for (unsigned i=0; i<NL; i++) for (unsigned j=0; j<NC; j++)
+        {
+            if (!L.celulaLivre(Coord(i,j))) continue;
+            noh[NC*i+j] = celula.size();
+            celula.push_back(NC*i+j);
+        }
+    unsigned N = celula.size();
+
+    // Grafo dos movimentos validos
+    ConstrucaoCH C(N);
+    Coord dir;
+    for (unsigned v=0; v<N; v++)
+    {
+        Coord pos(celula[v]/NC, celula[v]%NC);
+        for (dir.lin = -1; dir.lin < 2; dir.lin++) for (dir.col = -1; dir.col < 2; dir.col++)
+            {
+                Coord prox = pos + dir;
+                if (dir == Coord(0,0) || !L.movimentoValido(pos, prox)) continue;
+                ArestaTrabalho A = {unsigned(noh[NC*prox.lin+prox.col]), -1, norm(dir), 1};
+                C.adj[v].push_back(A);
+            }
+    }
+
+    // Prioridade de contracao (menor primeiro): profundidade (1 + a maior profundidade
+    // dos vizinhos jah contraidos), quociente de arestas (atalhos criados / arestas removidas)
+    // e quociente de passos (movimentos do mapa representados pelos atalhos / pelas arestas
+    // removidas)
+    // A profundidade espalha a contracao pelo mapa, o que deixa a hierarquia rasa e o
+    // espaco de busca das consultas pequeno
+    // Os atalhos sao estimados (estimaAtalhos): a busca de testemunhas completa soh eh
+    // feita na contracao
+    vector<unsigned> profundidade(N, 0);
+    auto prioridade = [&](unsigned v) -> double
+    {
+        const vector<ArestaTrabalho>& viz = C.adj[v];
+        if (viz.empty()) return profundidade[v];
+        unsigned numAtalhosV, passosCriados, passosRemovidos = 0;
+        C.estimaAtalhos(v, numAtalhosV, passosCriados);
+        for (const ArestaTrabalho& A : viz) passosRemovidos += A.passos;
+        return profundidade[v] + 2.0*numAtalhosV/viz.size() + 2.0*passosCriados/passosRemovidos;
+    };
+
+    typedef pair<double,unsigned> EntradaPrio;
+    priority_queue<EntradaPrio, vector<EntradaPrio>, greater<EntradaPrio> > ordem;
+    vector<double> prio(N);
+    for (unsigned v=0; v<N; v++)
+    {
+        prio[v] = prioridade(v);
+        ordem.push(EntradaPrio(prio[v], v));
+    }
+
+    // Contracao: as prioridades dos vizinhos sao recalculadas a cada contracao;
+    // as demais, somente quando o noh chega ao topo da fila (atualizacao preguicosa)
+    vector<AtalhoCH> S;
+    vector<unsigned> viz, contraidos;
+    contraidos.reserve(N);
+    while (!ordem.empty())
+    {
+        EntradaPrio E = ordem.top();
+        ordem.pop();
+        unsigned v = E.second;
+        // Entradas substituidas por uma prioridade mais recente sao descartadas
+        if (C.contraido[v] || E.first != prio[v]) continue;
+
+        double p = prioridade(v);
+        if (!ordem.empty() && p > ordem.top().first)
+        {
+            prio[v] = p;
+            ordem.push(EntradaPrio(p, v));
+            continue;
+        }
+
+        C.atalhos(v, S);
+        numAtalhos += S.size();
+        viz.clear();
+        for (const ArestaTrabalho& A : C.adj[v]) viz.push_back(A.para);
+        C.contrai(v, S);
+        contraidos.push_back(v);
+        for (unsigned u : viz)
+        {
+            profundidade[u] = max(profundidade[u], profundidade[v]+1);
+            prio[u] = prioridade(u);
+            ordem.push(EntradaPrio(prio[u], u));
+        }
+    }
+
+    // Renumera os nos do ultimo contraido (noh 0) ao primeiro: os nos de nivel alto, que
+    // aparecem em quase todas as consultas, ficam proximos na memoria
+    vector<unsigned> novo(N);
+    for (unsigned k=0; k<N; k++) novo[contraidos[k]] = N-1-k;
+    vector<unsigned> celulaAntiga;
+    celulaAntiga.swap(celula);
+    celula.resize(N);
+    for (unsigned v=0; v<N; v++)
+    {
+        celula[novo[v]] = celulaAntiga[v];
+        noh[celulaAntiga[v]] = novo[v];
+    }
+
+    // Grafo de busca: as arestas de cada noh para os nos de nivel maior
+    inicio.assign(N+1, 0);
+    for (unsigned k=0; k<N; k++)
+    {
+        unsigned v = contraidos[N-1-k];
+        inicio[k] = arestas.size();
+        for (ArestaCH A : C.subida[v])
+        {
+            A.para = novo[A.para];
+            if (A.meio >= 0) A.meio = novo[A.meio];
+            arestas.push_back(A);
+        }
+    }
+    inicio[N] = arestas.size();
+    return true;
+}
+
+/// Retorna a aresta de busca entre os nos a e b (guardada no noh de menor nivel)
+const ArestaCH* HierarquiaContracao::aresta(unsigned a, unsigned b) const
+{
+    for (unsigned k=inicio[a]; k<inicio[a+1]; k++) if (arestas[k].para == b) return &arestas[k];
+    for (unsigned k=inicio[b]; k<inicio[b+1]; k++) if (arestas[k].para == a) return &arestas[k];
+    return nullptr;
+}
+
+/// Acrescenta em "nos" os nos do caminho correspondente a aresta a->b (sem o noh a)
+/// Os atalhos sao expandidos com uma pilha explicita dos trechos ainda por expandir (o do
+/// topo eh o proximo do caminho), e nao por recursao
+void HierarquiaContracao::expande(unsigned a, unsigned b, vector<unsigned>& nos) const
+{
+    vector<pair<unsigned, unsigned>> pilha(1, make_pair(a, b));
+    while (!pilha.empty())
+    {
+        const pair<unsigned, unsigned> T = pilha.back();
+        pilha.pop_back();
+        const ArestaCH* A = aresta(T.first, T.second);
+        if (A == nullptr || A->meio < 0)
+        {
+            nos.push_back(T.second);
+            continue;
+        }
+        pilha.push_back(make_pair(unsigned(A->meio), T.second));
+        pilha.push_back(make_pair(T.first, unsigned(A->meio)));
+    }
+}
+
+/// Memoria das consultas de uma thread, reusada entre as consultas (e as hierarquias)
+/// A distancia e o pai de um noh em cada sentido soh valem se a sua marca for a da
+/// consulta atual: nada eh apagado entre as consultas
+struct MemoriaConsultaCH
+{
+    /// O estado de um noh em um sentido (16 bytes, lidos juntos)
+    struct Estado
+    {
+        double dist;
+        unsigned pai;
+        unsigned marca;
+    };
+
+    vector<Estado> estado[2];
+    unsigned consulta;
+    /// Heaps (menor distancia primeiro) dos dois sentidos
+    vector<EntradaCH> heap[2];
+
+    MemoriaConsultaCH(): consulta(0) {}
+
+    /// Prepara uma nova consulta em um grafo de N nos
+    void iniciar(unsigned N)
+    {
+        Estado nenhum = {0.0, 0, 0};
+        if (estado[0].size() < N)
+        {
+            estado[0].assign(N, nenhum);
+            estado[1].assign(N, nenhum);
+            consulta = 0;
+        }
+        if (++consulta == 0)
+        {
+            // O contador deu a volta: as marcas antigas poderiam parecer atuais
+            fill(estado[0].begin(), estado[0].end(), nenhum);
+            fill(estado[1].begin(), estado[1].end(), nenhum);
+            consulta = 1;
+        }
+        heap[0].clear();
+        heap[1].clear();
+    }
+
+    /// Testa se v foi alcancado no sentido k e, nesse caso, retorna a sua distancia em d
+    bool alcancado(int k, unsigned v, double& d) const
+    {
+        const Estado& E = estado[k][v];
+        d = E.dist;
+        return E.marca == consulta;
+    }
+
+    /// Fixa a distancia e o pai de v no sentido k e coloca v no heap
+    void alcanca(int k, unsigned v, double d, unsigned p)
+    {
+        Estado& E = estado[k][v];
+        E.dist = d;
+        E.pai = p;
+        E.marca = consulta;
+        heap[k].push_back(EntradaCH(d, v));
+        push_heap(heap[k].begin(), heap[k].end(), greater<EntradaCH>());
+    }
+};
+
+/// Calcula o menor caminho entre Or e De (busca bidirecional para cima na hierarquia)
+/// Poda por "stall-on-demand": um noh cuja distancia pode ser melhorada por um vizinho de
+/// nivel maior (pelas mesmas arestas, que sao simetricas) nao esta no menor caminho
+/// e nao eh expandido
+double HierarquiaContracao::consultar(const Coord& Or, const Coord& De, vector<Coord>& pontos) const
+{
+    pontos.clear();
+    if (empty() || !Or.valida() || !De.valida() || Or.lin >= int(NL) || De.lin >= int(NL) ||
+            Or.col >= int(NC) || De.col >= int(NC) ||
+            noh[NC*Or.lin+Or.col] < 0 || noh[NC*De.lin+De.col] < 0)
+    {
+        return -1.0;
+    }
+    unsigned s = noh[NC*Or.lin+Or.col], t = noh[NC*De.lin+De.col];
+
+    // Uma memoria por thread: a hierarquia pode ser consultada por varias threads
+    static thread_local MemoriaConsultaCH M;
+    M.iniciar(celula.size());
+    M.alcanca(0, s, 0.0, s);
+    M.alcanca(1, t, 0.0, t);
+
+    double melhor = numeric_limits<double>::infinity();
+    unsigned encontro = 0;
+    while (!M.heap[0].empty() || !M.heap[1].empty())
+    {
+        // Avanca o sentido de menor distancia
+        int k = (M.heap[1].empty() ||
+                 (!M.heap[0].empty() && M.heap[0].front().first <= M.heap[1].front().first)) ? 0 : 1;
+        pop_heap(M.heap[k].begin(), M.heap[k].end(), greater<EntradaCH>());
+        EntradaCH E = M.heap[k].back();
+        M.heap[k].pop_back();
+        if (E.first >= melhor)
+        {
+            // Este sentido nao pode mais melhorar o resultado
+            M.heap[k].clear();
+            continue;
+        }
+        unsigned v = E.second;
+        if (E.first > M.estado[k][v].dist) continue;
+
+        double d;
+        if (M.alcancado(1-k, v, d) && E.first + d < melhor)
+        {
+            melhor = E.first + d;
+            encontro = v;
+        }
+
+        bool parado = false;
+        for (unsigned a=inicio[v]; !parado && a<inicio[v+1]; a++)
+        {
+            const ArestaCH& A = arestas[a];
+            parado = M.alcancado(k, A.para, d) && d + A.peso < E.first;
+        }
+        if (parado) continue;
+
+        for (unsigned a=inicio[v]; a<inicio[v+1]; a++)
+        {
+            const ArestaCH& A = arestas[a];
+            if (!M.alcancado(k, A.para, d) || E.first + A.peso < d) M.alcanca(k, A.para, E.first + A.peso, v);
+        }
+    }
+    if (melhor == numeric_limits<double>::infinity()) return -1.0;
+
+    // Monta a sequencia de nos da busca: s ... encontro ... t
+    vector<unsigned> subida;
+    for (unsigned v=encontro; v!=s; v=M.estado[0][v].pai) subida.push_back(v);
+    subida.push_back(s);
+    reverse(subida.begin(), subida.end());
+    for (unsigned v=encontro; v!=t; ) subida.push_back(v = M.estado[1][v].pai);
+
+    // Expande os atalhos
+    vector<unsigned> nos(1, s);
+    for (unsigned k=1; k<subida.size(); k++) expande(subida[k-1], subida[k], nos);
+    for (unsigned v : nos) pontos.push_back(Coord(celula[v]/NC, celula[v]%NC));
+    return melhor;
+}
+
+/// Salva a hierarquia em um arquivo binario (formato LABCH002, com os inteiros em
+/// little-endian e os pesos como double IEEE-754 de 64 bits, ver binario.h)
+bool HierarquiaContracao::salvar(const string& nome_arq) const
+{
+    if (empty()) return false;
+
+    ofstream arq(nome_arq.c_str(), ios::binary);
+    if (!arq.is_open())
+    {
+        return false;
+    }
+    const unsigned N = celula.size(), M = arestas.size();
+    vector<unsigned char> buf(TAM_CABEC_CH + size_t(2*N+1)*4 + size_t(M)*TAM_ARESTA_CH);
+    unsigned char* p = buf.data();
+    copy(MARCA_CH, MARCA_CH+8, p);
+    escreveU32(p+8, NL);
+    escreveU32(p+12, NC);
+    escreveU64(p+16, assinatura);
+    escreveU32(p+24, N);
+    escreveU32(p+28, M);
+    escreveU32(p+32, numAtalhos);
+    p += TAM_CABEC_CH;
+    for (unsigned v=0; v<N; v++, p+=4) escreveU32(p, celula[v]);
+    for (unsigned v=0; v<=N; v++, p+=4) escreveU32(p, inicio[v]);
+    for (const ArestaCH& A : arestas)
+    {
+        uint64_t peso;
+        memcpy(&peso, &A.peso, sizeof(peso));
+        escreveU32(p, A.para);
+        escreveU32(p+4, unsigned(A.meio));
+        escreveU64(p+8, peso);
+        p += TAM_ARESTA_CH;
+    }
+    arq.write((const char*)buf.data(), buf.size());
+    arq.close();
+    return bool(arq);
+}
+
+/// Leh a hierarquia de um arquivo binario, conferindo se corresponde ao mapa L
+/// O tamanho do arquivo deve ser exatamente o indicado pelo cabecalho, e as arestas devem
+/// respeitar a ordem da hierarquia: cada aresta do noh v vai para um noh mais importante
+/// (para < v) e o noh do meio de um atalho eh menos importante que as duas pontas (meio > v)
+bool HierarquiaContracao::ler(const string& nome_arq, const Labirinto& L)
+{
+    *this = HierarquiaContracao();
+
+    ifstream arq(nome_arq.c_str(), ios::binary);
+    if (!arq.is_open())
+    {
+        return false;
+    }
+    arq.seekg(0, ios::end);
+    const streamoff tamArq = arq.tellg();
+    arq.seekg(0, ios::beg);
+
+    unsigned char cabec[TAM_CABEC_CH];
+    arq.read((char*)cabec, TAM_CABEC_CH);
+    if (!arq || tamArq < 0 || !equal(MARCA_CH, MARCA_CH+8, cabec))
+    {
+        return false;
+    }
+    const unsigned N = leU32(cabec+24), M = leU32(cabec+28);
+    if (leU32(cabec+8) != L.getNumLin() || leU32(cabec+12) != L.getNumCol() ||
+            leU64(cabec+16) != assinaturaMapa(L) || N > L.getNumLin()*L.getNumCol() ||
+            uint64_t(tamArq) != TAM_CABEC_CH + uint64_t(2*uint64_t(N)+1)*4 + uint64_t(M)*TAM_ARESTA_CH)
+    {
+        return false;
+    }
+
+    vector<unsigned char> buf(size_t(tamArq) - TAM_CABEC_CH);
+    arq.read((char*)buf.data(), buf.size());
+    if (!arq) return false;
+
+    NL = L.getNumLin();
+    NC = L.getNumCol();
+    assinatura = leU64(cabec+16);
+    numAtalhos = leU32(cabec+32);
+    celula.resize(N);
+    inicio.resize(N+1);
+    arestas.resize(M);
+    const unsigned char* p = buf.data();
+    for (unsigned v=0; v<N; v++, p+=4) celula[v] = leU32(p);
+    for (unsigned v=0; v<=N; v++, p+=4) inicio[v] = leU32(p);
+    for (ArestaCH& A : arestas)
+    {
+        uint64_t peso = leU64(p+8);
+        A.para = leU32(p);
+        A.meio = int(leU32(p+4));
+        memcpy(&A.peso, &peso, sizeof(peso));
+        p += TAM_ARESTA_CH;
+    }
+
+    bool ok = inicio[0] == 0 && inicio[N] == M;
+    noh.assign(NL*NC, -1);
+    for (unsigned v=0; ok && v<N; v++)
+    {
+        ok = celula[v] < NL*NC && noh[celula[v]] < 0 && inicio[v] <= inicio[v+1];
+        if (ok) noh[celula[v]] = v;
+    }
+    for (unsigned v=0; ok && v<N; v++)
+    {
+        for (unsigned k=inicio[v]; ok && k<inicio[v+1]; k++)
+        {
+            const ArestaCH& A = arestas[k];
+            ok = A.para < v && (A.meio == -1 || (A.meio > int(v) && A.meio < int(N))) && A.peso >= 0.0;
+        }
+    }
+    if (!ok) *this = HierarquiaContracao();
+    return ok;
+}
+
+/// Funcoes de consulta
+bool HierarquiaContracao::empty() const
+{
+    return celula.empty();
+}
+
+unsigned HierarquiaContracao::getNumNos() const
+{
+    return celula.size();
+}
+
+unsigned HierarquiaContracao::getNumArestas() const
+{
+    return arestas.size();
+}
+
+unsigned HierarquiaContracao::getNumAtalhos() const
+{
+    return numAtalhos;
+}
+
+size_t HierarquiaContracao::getTamanhoBytes() const
+{
+    return noh.size()*sizeof(int) + celula.size()*sizeof(unsigned) +
+           inicio.size()*sizeof(unsigned) + arestas.size()*sizeof(ArestaCH);
+}
+
+/* ***************** */
+/* BENCHMARK         */
+/* ***************** */
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Mede o pre-processamento do mapa L e compara as consultas com calculaCaminho
+void benchPreprocessamento(ostream& O, Labirinto& L, const string& nome_arq, unsigned numConsultas)
+{
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    if (!L.preprocessar())
+    {
+        O << "Mapa vazio...\n";
+        return;
+    }
+    double tPre = milissegundos(t1);
+    shared_ptr<const HierarquiaContracao> H = L.getPreprocessamento();
+
+    O << "PRE-PROCESSAMENTO " << L.getNumLin() << 'x' << L.getNumCol() << endl;
+    O << fixed << setprecision(3)
+      << "Tempo=" << tPre << "ms\t Nos=" << H->getNumNos() << "\t Arestas=" << H->getNumArestas()
+      << "\t Atalhos=" << H->getNumAtalhos() << "\t Tamanho=" << H->getTamanhoBytes() << " bytes" << endl;
+
+    if (!nome_arq.empty())
+    {
+        t1 = chrono::steady_clock::now();
+        bool ok = L.salvarPreprocessamento(nome_arq) && L.lerPreprocessamento(nome_arq);
+        O << "Arquivo " << nome_arq << EXTENSAO_PREPROCESSAMENTO
+          << (ok ? " salvo e lido em " : " ERRO apos ") << milissegundos(t1) << "ms" << endl;
+        if (!ok) return;
+    }
+
+    // Pares de celulas livres sorteadas (com semente fixa)
+    vector<Coord> livres;
+    for (unsigned i=0; i<L.getNumLin(); i++) for (unsigned j=0; j<L.getNumCol(); j++)
+        {
+            if (L.celulaLivre(Coord(i,j))) livres.push_back(Coord(i,j));
+        }
+    if (livres.empty())
+    {
+        O << "Mapa sem celulas livres...\n";
+        return;
+    }
+    srand(1);
+    double tCalc = 0.0, tPreConsulta = 0.0;
+    unsigned diferencas = 0;
+    for (unsigned k=0; k<numConsultas; k++)
+    {
+        Coord Or = livres[rand()%livres.size()], De = livres[rand()%livres.size()];
+        vector<Coord> pontos;
+        int NC, NA, NF;
+
+        t1 = chrono::steady_clock::now();
+        double c1 = L.buscaPreprocessada(Or, De, pontos);
+        tPreConsulta += milissegundos(t1);
+
+        L.setOrigem(Or);
+        L.setDestino(De);
+        t1 = chrono::steady_clock::now();
+        double c2 = L.calculaCaminho(NC, NA, NF);
+        tCalc += milissegundos(t1);
+
+        bool valido = (c1 < 0.0 || (pontos.front() == Or && pontos.back() == De));
+        for (unsigned p=1; valido && p<pontos.size(); p++) valido = L.movimentoValido(pontos[p-1], pontos[p]);
+        if (fabs(c1-c2) > 1e-6 || !valido) diferencas++;
+    }
+    O << numConsultas << " consultas: pre-processada=" << 1000*tPreConsulta/max(numConsultas, 1u)
+      << "us/consulta\t calculaCaminho=" << 1000*tCalc/max(numConsultas, 1u)
+      << "us/consulta\t Aceleracao=" << tCalc/max(tPreConsulta, 1e-9) << 'x' << endl;
+    O << "Diferencas=" << diferencas << endl;
+}
@@ -0,0 +1,83 @@
+#ifndef _CONTRACAO_H_
+#define _CONTRACAO_H_
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include "labirinto.h"
+
+/// Uma aresta do grafo de busca da hierarquia de contracao
+/// "meio" eh o noh contraido que a aresta substitui (atalho), ou -1 para um movimento do mapa
+struct ArestaCH
+{
+    unsigned para;
+    int meio;
+    double peso;
+};
+
+/// Hierarquia de contracao do grafo das celulas livres de um mapa estatico
+/// Os nos (celulas livres) sao contraidos um a um em ordem de importancia; ao contrair um
+/// noh, atalhos sao criados entre os vizinhos cujo menor caminho passava por ele
+/// Uma consulta eh uma busca bidirecional que soh sobe na hierarquia, seguida da
+/// expansao dos atalhos; o resultado eh exato (mesmo comprimento de calculaCaminho)
+/// Depois de construida, eh imutavel e pode ser consultada por varias threads
+/// (cada thread reusa a sua propria memoria de consulta)
+class HierarquiaContracao
+{
+private:
+    /// Dimensoes e assinatura (dos obstaculos) do mapa de origem
+    unsigned NL, NC;
+    uint64_t assinatura;
+    /// Celula (indice linha a linha, NC*i+j) -> noh (-1 = obstaculo)
+    vector<int> noh;
+    /// Noh -> celula
+    /// Os nos sao numerados do mais importante (o ultimo contraido, noh 0) ao menos importante
+    vector<unsigned> celula;
+    /// Grafo de busca: as arestas de cada noh para nos mais importantes
+    /// As arestas do noh v sao arestas[inicio[v]] ... arestas[inicio[v+1]-1]
+    vector<unsigned> inicio;
+    vector<ArestaCH> arestas;
+    /// Numero de atalhos criados na construcao
+    unsigned numAtalhos;
+
+    /// Retorna a aresta de busca entre os nos a e b (nullptr se nao existe)
+    const ArestaCH* aresta(unsigned a, unsigned b) const;
+    /// Acrescenta em "nos" os nos do caminho correspondente a aresta a->b (sem o noh a)
+    void expande(unsigned a, unsigned b, vector<unsigned>& nos) const;
+
+public:
+    HierarquiaContracao();
+
+    /// Assinatura dos obstaculos de um mapa (para conferir se o arquivo corresponde ao mapa)
+    static uint64_t assinaturaMapa(const Labirinto& L);
+
+    /// Constroi a hierarquia para o mapa L
+    /// Retorna false se o mapa estiver vazio
+    bool construir(const Labirinto& L);
+
+    /// Salva / leh a hierarquia em um arquivo binario
+    /// Na leitura, o arquivo deve corresponder ao mapa L (mesmas dimensoes e obstaculos)
+    bool salvar(const string& nome_arq) const;
+    bool ler(const string& nome_arq, const Labirinto& L);
+
+    /// Calcula o menor caminho entre Or e De
+    /// Preenche "pontos" com as celulas do caminho e retorna o seu comprimento (<0 se nao existe)
+    double consultar(const Coord& Or, const Coord& De, vector<Coord>& pontos) const;
+
+    /// Funcoes de consulta
+    bool empty() const;
+    unsigned getNumNos() const;
+    unsigned getNumArestas() const;
+    unsigned getNumAtalhos() const;
+    /// Tamanho aproximado em memoria, em bytes
+    size_t getTamanhoBytes() const;
+};
+
+/// Mede o pre-processamento do mapa L (tempo, tamanho do indice) e compara o tempo de
+/// numConsultas consultas aleatorias com calculaCaminho
+/// Se nome_arq nao for vazio, salva o indice ao lado do mapa e o le de volta
+/// Escreve em O os resultados e o numero de comprimentos divergentes
+void benchPreprocessamento(std::ostream& O, Labirinto& L, const string& nome_arq,
+                           unsigned numConsultas=100);
+
+#endif // _CONTRACAO_H_
@@ -0,0 +1,403 @@
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "desenho.h"
+
+using namespace std;
+
+/// Numero de estados de celula (EstadoCel)
+#define NUM_ESTADOS_CEL 5
+/// Base do nome do arquivo temporario das medicoes de benchDesenho
+#define ARQ_DESENHO "desenho.tmp"
+
+/* ***************** */
+/* DESENHO EM TEXTO  */
+/* ***************** */
+
+/// Numero de digitos decimais de n
+static unsigned numDigitos(unsigned n)
+{
+    unsigned d = 1;
+    while (n >= 10)
+    {
+        n /= 10;
+        d++;
+    }
+    return d;
+}
+
+/// Escreve n em p com "largura" digitos (completando com zeros a esquerda)
+/// Retorna a posicao seguinte ao ultimo digito
+static char* escreveNumero(char* p, unsigned n, unsigned largura)
+{
+    for (unsigned k=largura; k>0; k--)
+    {
+        p[k-1] = '0' + n%10;
+        n /= 10;
+    }
+    return p + largura;
+}
+
+/// Escreve em p a linha de borda "   +--+--+ ... +" (com o recuo dos indices)
+static char* escreveBorda(char* p, unsigned recuo, unsigned numC)
+{
+    p = fill_n(p, recuo+1, ' ');
+    *p++ = '+';
+    for (unsigned j=0; j<numC; j++)
+    {
+        *p++ = '-';
+        *p++ = '-';
+        *p++ = '+';
+    }
+    *p++ = '\n';
+    return p;
+}
+
+/// Limita a janela J ao mapa L (pode ficar vazia)
+static Janela limitaJanela(const Labirinto& L, Janela J)
+{
+    J.lin = min(J.lin, L.getNumLin());
+    J.col = min(J.col, L.getNumCol());
+    J.numL = min(J.numL, L.getNumLin() - J.lin);
+    J.numC = min(J.numC, L.getNumCol() - J.col);
+    return J;
+}
+
+/// Acrescenta a buf o desenho das celulas da janela J
+void desenhaJanela(string& buf, const Labirinto& L, const Janela& Jan)
+{
+    Janela J = limitaJanela(L, Jan);
+    if (J.numL == 0 || J.numC == 0) return;
+
+    // Simbolos de cada estado (os mesmos de estadoCel2string)
+    char simbolo[NUM_ESTADOS_CEL][2];
+    for (unsigned e=0; e<NUM_ESTADOS_CEL; e++)
+    {
+        string S = estadoCel2string(EstadoCel(e));
+        simbolo[e][0] = S[0];
+        simbolo[e][1] = S[1];
+    }
+
+    // Largura dos indices das linhas e tamanho de cada linha do desenho
+    const unsigned W = max(2u, numDigitos(J.lin + J.numL - 1));
+    // (o cabecalho, as bordas e as linhas de celulas tem o mesmo tamanho)
+    const size_t tamLinha = (W+2) + 3*size_t(J.numC) + 1;
+    const size_t inicio = buf.size();
+    buf.resize(inicio + (2 + 2*size_t(J.numL))*tamLinha);
+    char* p = &buf[inicio];
+
+    // Cabecalho
+    p = fill_n(p, W+2, ' ');
+    for (unsigned j=J.col; j<J.col+J.numC; j++)
+    {
+        p = escreveNumero(p, j%100, 2);
+        *p++ = ' ';
+    }
+    *p++ = '\n';
+    p = escreveBorda(p, W, J.numC);
+
+    // Linhas
+    for (unsigned i=J.lin; i<J.lin+J.numL; i++)
+    {
+        p = escreveNumero(p, i, W);
+        *p++ = ' ';
+        *p++ = '|';
+        for (unsigned j=J.col; j<J.col+J.numC; j++)
+        {
+            const char* S = simbolo[unsigned(L.at(i,j))];
+            *p++ = S[0];
+            *p++ = S[1];
+            *p++ = '|';
+        }
+        *p++ = '\n';
+        p = escreveBorda(p, W, J.numC);
+    }
+}
+
+/// Acrescenta a buf uma visao geral reduzida do mapa
+void desenhaVisaoGeral(string& buf, const Labirinto& L, unsigned maxLin, unsigned maxCol)
+{
+    const unsigned NL = L.getNumLin(), NC = L.getNumCol();
+    if (NL == 0 || NC == 0 || maxLin == 0 || maxCol == 0) return;
+
+    // Dimensoes de cada bloco e do desenho
+    const unsigned BL = (NL + maxLin - 1)/maxLin, BC = (NC + maxCol - 1)/maxCol;
+    const unsigned DL = (NL + BL - 1)/BL, DC = (NC + BC - 1)/BC;
+
+    // Conta, para os blocos de uma faixa de linhas, os obstaculos e as marcas
+    // (marca: 0 nenhuma, 1 caminho, 2 destino, 3 origem)
+    static const char tons[] = " .:+#";
+    static const char marcas[] = " *DO";
+    vector<unsigned> obstaculos(DC);
+    vector<unsigned char> marca(DC);
+
+    char legenda[160];
+    int tamLegenda = snprintf(legenda, sizeof(legenda),
+                              "Visao geral: %ux%u celulas, cada caractere = %ux%u celulas\n",
+                              NL, NC, BL, BC);
+    const size_t inicio = buf.size();
+    buf.resize(inicio + tamLegenda + (DL+2)*(DC+3));
+    char* p = copy(legenda, legenda+tamLegenda, &buf[inicio]);
+
+    *p++ = '+';
+    p = fill_n(p, DC, '-');
+    *p++ = '+';
+    *p++ = '\n';
+    for (unsigned bi=0; bi<DL; bi++)
+    {
+        fill(obstaculos.begin(), obstaculos.end(), 0);
+        fill(marca.begin(), marca.end(), 0);
+        const unsigned i1 = min(NL, (bi+1)*BL);
+        for (unsigned i=bi*BL; i<i1; i++) for (unsigned j=0; j<NC; j++)
+            {
+                unsigned char m = 0;
+                switch (L.at(i,j))
+                {
+                case EstadoCel::OBSTACULO:
+                    obstaculos[j/BC]++;
+                    break;
+                case EstadoCel::CAMINHO:
+                    m = 1;
+                    break;
+                case EstadoCel::DESTINO:
+                    m = 2;
+                    break;
+                case EstadoCel::ORIGEM:
+                    m = 3;
+                    break;
+                default:
+                    break;
+                }
+                if (m > marca[j/BC]) marca[j/BC] = m;
+            }
+
+        *p++ = '|';
+        for (unsigned bj=0; bj<DC; bj++)
+        {
+            if (marca[bj] > 0) *p++ = marcas[marca[bj]];
+            else
+            {
+                // Fracao de obstaculos do bloco, arredondada para cima em quartos
+                unsigned total = (i1 - bi*BL) * (min(NC, (bj+1)*BC) - bj*BC);
+                *p++ = tons[(4*obstaculos[bj] + total - 1)/total];
+            }
+        }
+        *p++ = '|';
+        *p++ = '\n';
+    }
+    *p++ = '+';
+    p = fill_n(p, DC, '-');
+    *p++ = '+';
+    *p++ = '\n';
+}
+
+/// Menor janela que contem o ultimo caminho calculado (ou a origem e o destino)
+Janela janelaCaminho(const Labirinto& L, unsigned margem)
+{
+    const vector<Coord>& caminho = L.getCaminho();
+    vector<Coord> pontos(caminho.begin(), caminho.end());
+    if (pontos.empty())
+    {
+        if (L.getOrig().valida() && L.coordValida(L.getOrig())) pontos.push_back(L.getOrig());
+        if (L.getDest().valida() && L.coordValida(L.getDest())) pontos.push_back(L.getDest());
+    }
+    if (pontos.empty())
+    {
+        return limitaJanela(L, Janela(0, 0, ALTURA_MAX_CONSOLE, LARGURA_MAX_CONSOLE));
+    }
+
+    Coord A = pontos.front(), B = pontos.front();
+    for (const Coord& C : pontos)
+    {
+        A.lin = min(A.lin, C.lin);
+        A.col = min(A.col, C.col);
+        B.lin = max(B.lin, C.lin);
+        B.col = max(B.col, C.col);
+    }
+    return limitaJanela(L, Janela::envolvente(A, B, margem));
+}
+
+/// Escreve buf na saida padrao com uma unica chamada
+void escreveConsole(const string& buf)
+{
+    cout.write(buf.data(), buf.size());
+    cout.flush();
+}
+
+/// Imprime o mapa no console (inteiro, ou visao geral e janela em torno do caminho)
+void imprimeConsole(const Labirinto& L)
+{
+    if (L.empty() || (L.getNumLin() <= ALTURA_MAX_CONSOLE && L.getNumCol() <= LARGURA_MAX_CONSOLE))
+    {
+        L.imprimir();
+        return;
+    }
+
+    string buf;
+    desenhaVisaoGeral(buf, L);
+    Janela J = janelaCaminho(L);
+    J.numL = min(J.numL, unsigned(ALTURA_MAX_CONSOLE));
+    J.numC = min(J.numC, unsigned(LARGURA_MAX_CONSOLE));
+    char legenda[160];
+    int tam = snprintf(legenda, sizeof(legenda), "Janela: linhas %u a %u, colunas %u a %u\n",
+                       J.lin, J.lin+J.numL-1, J.col, J.col+J.numC-1);
+    buf.append(legenda, tam);
+    desenhaJanela(buf, L, J);
+    escreveConsole(buf);
+}
+
+/* ***************** */
+/* IMAGENS           */
+/* ***************** */
+
+/// Exporta o mapa e o caminho como imagem
+bool exportaImagem(const Labirinto& L, const string& nome_arq, FormatoImagem F, unsigned escala)
+{
+    if (L.empty() || escala == 0) return false;
+    ofstream arq(nome_arq.c_str(), ios::binary);
+    if (!arq.is_open()) return false;
+
+    // Cor de cada estado (LIVRE, OBSTACULO, ORIGEM, DESTINO, CAMINHO)
+    static const unsigned char cinza[NUM_ESTADOS_CEL] = {255, 0, 64, 64, 128};
+    static const unsigned char rgb[NUM_ESTADOS_CEL][3] =
+    {
+        {255, 255, 255}, {40, 40, 40}, {0, 170, 0}, {220, 0, 0}, {30, 100, 230}
+    };
+    const unsigned canais = (F == FormatoImagem::PPM ? 3 : 1);
+    const unsigned NL = L.getNumLin(), NC = L.getNumCol();
+
+    arq << (F == FormatoImagem::PPM ? "P6" : "P5") << '\n'
+        << NC*escala << ' ' << NL*escala << '\n' << 255 << '\n';
+
+    // Cada linha do mapa eh montada uma vez e escrita "escala" vezes
+    vector<unsigned char> linha(size_t(NC)*escala*canais);
+    for (unsigned i=0; i<NL; i++)
+    {
+        unsigned char* p = linha.data();
+        for (unsigned j=0; j<NC; j++)
+        {
+            unsigned e = unsigned(L.at(i,j));
+            for (unsigned k=0; k<escala; k++)
+            {
+                if (canais == 1) *p++ = cinza[e];
+                else p = copy(rgb[e], rgb[e]+3, p);
+            }
+        }
+        for (unsigned k=0; k<escala; k++) arq.write((const char*)linha.data(), linha.size());
+    }
+    return bool(arq);
+}
+
+/* ***************** */
+/* BENCHMARK         */
+/* ***************** */
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Impressao celula a celula, como na versao anterior de Labirinto::imprimir
+/// (manipuladores e endl a cada linha)
+static void imprimeCelulas(ostream& O, const Labirinto& L)
+{
+    const unsigned NL = L.getNumLin(), NC = L.getNumCol();
+    O << "    ";
+    for (unsigned j=0; j<NC; j++) O << setfill('0') << setw(2) << j << setfill(' ') << setw(0) << ' ';
+    O << endl;
+    O << "   +";
+    for (unsigned j=0; j<NC; j++) O << "--+";
+    O << endl;
+    for (unsigned i=0; i<NL; i++)
+    {
+        O << setfill('0') << setw(2) << i << setfill(' ') << setw(0) << " |";
+        for (unsigned j=0; j<NC; j++) O << estadoCel2string(L.at(i,j)) << '|';
+        O << endl;
+        O << "   +";
+        for (unsigned j=0; j<NC; j++) O << "--+";
+        O << endl;
+    }
+}
+
+/// Mede as formas de desenho de um mapa
+void benchDesenho(ostream& O, unsigned numL, unsigned numC, double perc_obst)
+{
+    Labirinto L;
+    if (!L.gerar(numL, numC, perc_obst))
+    {
+        O << "Parametros invalidos para a geracao do mapa\n";
+        return;
+    }
+
+    // Caminho entre cantos opostos (com semente fixa)
+    srand(1);
+    Coord Or, De;
+    do Or = Coord(rand()%(numL/4), rand()%(numC/4));
+    while (!L.celulaLivre(Or));
+    do De = Coord(numL-1-rand()%(numL/4), numC-1-rand()%(numC/4));
+    while (!L.celulaLivre(De));
+    L.setOrigem(Or);
+    L.setDestino(De);
+    int NC, NA, NF;
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    double compr = L.calculaCaminho(NC, NA, NF);
+    double tCaminho = milissegundos(t1);
+
+    O << "DESENHO " << numL << 'x' << numC << " obst=" << perc_obst << fixed << setprecision(3)
+      << ", caminho de comprimento " << compr << " em " << tCaminho << "ms" << endl;
+
+    // Impressao do mapa inteiro: celula a celula e com buffer unico
+    const string arqTemp = nomeTemporario(ARQ_DESENHO);
+    double tCelulas, tBuffer;
+    size_t bytes;
+    {
+        ofstream arq(arqTemp.c_str());
+        t1 = chrono::steady_clock::now();
+        imprimeCelulas(arq, L);
+        tCelulas = milissegundos(t1);
+    }
+    {
+        ofstream arq(arqTemp.c_str());
+        t1 = chrono::steady_clock::now();
+        string buf;
+        desenhaJanela(buf, L, Janela(0, 0, numL, numC));
+        arq.write(buf.data(), buf.size());
+        arq.flush();
+        tBuffer = milissegundos(t1);
+        bytes = buf.size();
+    }
+    remove(arqTemp.c_str());
+
+    t1 = chrono::steady_clock::now();
+    string visao;
+    desenhaVisaoGeral(visao, L);
+    double tVisao = milissegundos(t1);
+
+    t1 = chrono::steady_clock::now();
+    string janela;
+    desenhaJanela(janela, L, janelaCaminho(L));
+    double tJanela = milissegundos(t1);
+
+    t1 = chrono::steady_clock::now();
+    bool okPGM = exportaImagem(L, arqTemp, FormatoImagem::PGM);
+    double tPGM = milissegundos(t1);
+    t1 = chrono::steady_clock::now();
+    bool okPPM = exportaImagem(L, arqTemp, FormatoImagem::PPM);
+    double tPPM = milissegundos(t1);
+    remove(arqTemp.c_str());
+
+    O << "Mapa inteiro, celula a celula: " << tCelulas << "ms" << endl;
+    O << "Mapa inteiro, buffer unico:    " << tBuffer << "ms\t (" << bytes/1024 << "KB, "
+      << tCelulas/max(tBuffer, 1e-9) << "x mais rapido)" << endl;
+    O << "Visao geral:                   " << tVisao << "ms\t (" << visao.size() << " bytes)" << endl;
+    O << "Janela do caminho:             " << tJanela << "ms\t (" << janela.size()/1024 << "KB)" << endl;
+    O << "Imagem PGM:                    " << tPGM << "ms" << (okPGM ? "" : "\t ERRO") << endl;
+    O << "Imagem PPM:                    " << tPPM << "ms" << (okPPM ? "" : "\t ERRO") << endl;
+}
@@ -0,0 +1,69 @@
+#ifndef _DESENHO_H_
+#define _DESENHO_H_
+
+#include <iostream>
+#include <string>
+#include "labirinto.h"
+
+/// Dimensoes maximas (em celulas) de um mapa impresso por inteiro no console
+/// (os mapas gerados no programa interativo sempre sao impressos por inteiro; os lidos de
+/// arquivo podem ser maiores)
+#define ALTURA_MAX_CONSOLE ALTURA_MAX_MAPA
+#define LARGURA_MAX_CONSOLE LARGURA_MAX_MAPA
+/// Dimensoes maximas (em caracteres) da visao geral no console
+#define ALTURA_VISAO_GERAL 40
+#define LARGURA_VISAO_GERAL 120
+/// Margem (em celulas) da janela em torno do caminho
+#define MARGEM_JANELA_CAMINHO 3
+
+/// Formatos das imagens exportadas
+/// PGM: tons de cinza (P5); PPM: colorida (P6)
+enum class FormatoImagem
+{
+    PGM,
+    PPM
+};
+
+/// Desenho do mapa em texto
+/// As funcoes "desenha..." acrescentam o desenho ao final de buf: o tamanho final eh
+/// calculado antes e a memoria eh reservada uma unica vez
+/// O desenho completo eh escrito no console com uma unica chamada (escreveConsole)
+
+/// Acrescenta a buf o desenho das celulas da janela J, no formato de Labirinto::imprimir
+/// (celulas de 2 caracteres entre bordas, com os indices das linhas e das colunas)
+/// A janela eh limitada ao mapa; os indices sao os do mapa
+/// Com mais de 100 colunas, o cabecalho mostra os 2 ultimos digitos do indice
+void desenhaJanela(string& buf, const Labirinto& L, const Janela& J);
+
+/// Acrescenta a buf uma visao geral reduzida do mapa, com no maximo maxLin x maxCol caracteres
+/// Cada caractere representa um bloco de celulas: O/D se o bloco contem a origem/destino,
+/// * se contem parte do caminho; senao, um tom de acordo com a fracao de obstaculos
+/// (' ' nenhum, '.' ate 25%, ':' ate 50%, '+' ate 75%, '#' acima disso)
+void desenhaVisaoGeral(string& buf, const Labirinto& L, unsigned maxLin=ALTURA_VISAO_GERAL,
+                       unsigned maxCol=LARGURA_VISAO_GERAL);
+
+/// Menor janela que contem o ultimo caminho calculado (ou a origem e o destino, se nao
+/// houver caminho), acrescida de "margem" celulas em cada direcao e limitada ao mapa
+/// Sem caminho, origem nem destino, retorna o canto superior esquerdo do mapa
+Janela janelaCaminho(const Labirinto& L, unsigned margem=MARGEM_JANELA_CAMINHO);
+
+/// Escreve buf na saida padrao com uma unica chamada
+void escreveConsole(const string& buf);
+
+/// Imprime o mapa no console: inteiro, se couber em ALTURA_MAX_CONSOLE x LARGURA_MAX_CONSOLE;
+/// senao, a visao geral e a janela em torno do caminho (limitada as mesmas dimensoes)
+void imprimeConsole(const Labirinto& L);
+
+/// Exporta o mapa e o caminho como imagem no arquivo nome_arq
+/// Cada celula vira um quadrado de escala x escala pixels
+/// Retorna true em caso de escrita bem sucedida
+bool exportaImagem(const Labirinto& L, const string& nome_arq, FormatoImagem F, unsigned escala=1);
+
+/// Mede o desenho de um mapa numL x numC com perc_obst de obstaculos e um caminho entre
+/// cantos opostos: impressao celula a celula (como na versao anterior de imprimir) e com
+/// buffer unico, janela, visao geral e exportacao das imagens
+/// As impressoes sao feitas em um arquivo temporario (exclusivo, ver nomeTemporario),
+/// para nao encher o console
+void benchDesenho(std::ostream& O, unsigned numL, unsigned numC, double perc_obst);
+
+#endif // _DESENHO_H_
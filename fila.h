@@ -0,0 +1,77 @@
+#ifndef _FILA_H_
+#define _FILA_H_
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+/// Fila limitada com multiplos produtores e multiplos consumidores (MPMC)
+/// Os produtores escolhem entre esperar por espaco ou desistir quando a fila estah cheia;
+/// os consumidores esperam enquanto a fila estiver vazia e aberta
+template <class T>
+class FilaLimitada
+{
+private:
+    std::deque<T> itens;
+    unsigned capacidade;
+    bool fechada;
+
+    std::mutex trava;
+    std::condition_variable temEspaco;
+    std::condition_variable temItem;
+
+public:
+    /// Cria uma fila vazia que comporta no maximo cap itens
+    explicit FilaLimitada(unsigned cap): itens(), capacidade(cap), fechada(false) {}
+
+    /// Insere um item no final da fila
+    /// Se a fila estiver cheia, espera (esperar=true) ou desiste (esperar=false)
+    /// Retorna false se o item nao foi inserido (fila cheia ou fechada)
+    bool inserir(T&& item, bool esperar=true)
+    {
+        std::unique_lock<std::mutex> lock(trava);
+        if (esperar)
+        {
+            temEspaco.wait(lock, [this] { return fechada || itens.size() < capacidade; });
+        }
+        if (fechada || itens.size() >= capacidade) return false;
+        itens.push_back(std::move(item));
+        lock.unlock();
+        temItem.notify_one();
+        return true;
+    }
+
+    /// Retira o primeiro item da fila, esperando enquanto ela estiver vazia
+    /// Retorna false se a fila foi fechada e estah vazia
+    bool retirar(T& item)
+    {
+        std::unique_lock<std::mutex> lock(trava);
+        temItem.wait(lock, [this] { return fechada || !itens.empty(); });
+        if (itens.empty()) return false;
+        item = std::move(itens.front());
+        itens.pop_front();
+        lock.unlock();
+        temEspaco.notify_one();
+        return true;
+    }
+
+    /// Fecha a fila: novas insercoes falham e os consumidores terminam quando ela esvaziar
+    void fechar()
+    {
+        {
+            std::lock_guard<std::mutex> lock(trava);
+            fechada = true;
+        }
+        temEspaco.notify_all();
+        temItem.notify_all();
+    }
+
+    /// Numero de itens na fila
+    unsigned size()
+    {
+        std::lock_guard<std::mutex> lock(trava);
+        return itens.size();
+    }
+};
+
+#endif // _FILA_H_
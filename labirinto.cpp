@@ -1,11 +1,23 @@
 #include <iomanip>
 #include <fstream>
-#include <list>
 #include <algorithm>
 #include <cmath>
+#include <queue>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 
 #include "labirinto.h"
-#include "Noh.h"
+#include "binario.h"
+#include "arena.h"
+#include "contracao.h"
+#include "desenho.h"
 
 using namespace std;
 
@@ -33,25 +45,152 @@ string estadoCel2string(EstadoCel E)
     return "??";
 }
 
+string layout2string(LayoutMapa L)
+{
+    switch(L)
+    {
+    case LayoutMapa::LINHAS:
+        return "LINHAS";
+    case LayoutMapa::MORTON:
+        return "MORTON";
+    case LayoutMapa::BLOCOS:
+        return "BLOCOS";
+    default:
+        break;
+    }
+    return "??";
+}
+
+string nomeTemporario(const string& base)
+{
+    static atomic<unsigned> contador(0);
+    ostringstream ss;
+    ss << base << '.' << getpid() << '.' << contador++;
+    return ss.str();
+}
+
+/* ***************** */
+/* ORDEM DE MORTON   */
+/* ***************** */
+
+/// Mascaras dos bits de coluna (pares) e de linha (impares) de um indice de Morton
+#define MASC_MORTON_COL 0x55555555u
+#define MASC_MORTON_LIN 0xAAAAAAAAu
+
+/// Espalha os 16 bits menos significativos de x nos bits pares do resultado
+static unsigned espalhaBits(unsigned x)
+{
+    x &= 0x0000FFFF;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+/// Operacao inversa de espalhaBits: junta os bits pares de x
+static unsigned juntaBits(unsigned x)
+{
+    x &= 0x55555555;
+    x = (x | (x >> 1)) & 0x33333333;
+    x = (x | (x >> 2)) & 0x0F0F0F0F;
+    x = (x | (x >> 4)) & 0x00FF00FF;
+    x = (x | (x >> 8)) & 0x0000FFFF;
+    return x;
+}
+
+/* ******************* */
+/* CLASSE INTERRUPCAO  */
+/* ******************* */
+
+Interrupcao::Interrupcao(): cancelada(nullptr), prazo(), temPrazo(false), periodo(256) {}
+
+/// Testa se a busca deve ser interrompida
+bool Interrupcao::interromper() const
+{
+    if (cancelada != nullptr && cancelada->load(memory_order_relaxed)) return true;
+    if (temPrazo && chrono::steady_clock::now() >= prazo) return true;
+    return false;
+}
+
+/* ***************** */
+/* CLASSE JANELA     */
+/* ***************** */
+
+Janela::Janela(): lin(0), col(0), numL(0), numC(0) {}
+
+Janela::Janela(unsigned l, unsigned c, unsigned nL, unsigned nC): lin(l), col(c), numL(nL), numC(nC) {}
+
+/// Menor janela que contem A e B, acrescida de uma margem
+Janela Janela::envolvente(const Coord& A, const Coord& B, unsigned margem)
+{
+    int l0 = max(0, min(A.lin, B.lin) - int(margem));
+    int c0 = max(0, min(A.col, B.col) - int(margem));
+    int l1 = max(A.lin, B.lin) + int(margem);
+    int c1 = max(A.col, B.col) + int(margem);
+    return Janela(l0, c0, max(0, l1-l0+1), max(0, c1-c0+1));
+}
+
+/// Testa se a janela contem a celula C
+bool Janela::contem(const Coord& C) const
+{
+    return C.lin >= int(lin) && C.lin < int(lin+numL) && C.col >= int(col) && C.col < int(col+numC);
+}
+
+/// Ajusta a janela J a um mapa numL x numC: aumenta ate as dimensoes minimas e
+/// diminui ou desloca o que estiver fora do mapa
+static Janela ajustaJanela(Janela J, unsigned numL, unsigned numC)
+{
+    J.numL = min(max(J.numL, unsigned(ALTURA_MIN_MAPA)), numL);
+    J.numC = min(max(J.numC, unsigned(LARGURA_MIN_MAPA)), numC);
+    J.lin = min(J.lin, numL-J.numL);
+    J.col = min(J.col, numC-J.numC);
+    return J;
+}
+
 /* ***************** */
 /* CLASSE LABIRINTO  */
 /* ***************** */
 
 /// Construtores
 
+/// Dimensoes maximas aceitas por ler e gerar
+unsigned Labirinto::alturaMax = ALTURA_MAX_MAPA;
+unsigned Labirinto::larguraMax = LARGURA_MAX_MAPA;
+
+void Labirinto::setLimites(unsigned maxLin, unsigned maxCol)
+{
+    alturaMax = maxLin;
+    larguraMax = maxCol;
+}
+
+unsigned Labirinto::getAlturaMax()
+{
+    return alturaMax;
+}
+
+unsigned Labirinto::getLarguraMax()
+{
+    return larguraMax;
+}
+
 /// Default (labirinto vazio)
-Labirinto::Labirinto(): NL(0), NC(0), mapa(), orig(), dest() {}
+Labirinto::Labirinto(): NL(0), NC(0), paginas(), celulas(), numIndices(0),
+    layout(LayoutMapa::LINHAS), LB(0), TB(0),
+    orig(), dest(), caminho(), hierarquia(), janela(), NLArq(0), NCArq(0) {}
 
 /// Cria um mapa com dimensoes dadas
 /// numL e numC sao as dimensoes do labirinto
-Labirinto::Labirinto(unsigned numL, unsigned numC)
+Labirinto::Labirinto(unsigned numL, unsigned numC): numIndices(0), layout(LayoutMapa::LINHAS),
+    LB(0), TB(0)
 {
     gerar(numL, numC);
 }
 
 /// Cria um mapa com o conteudo do arquivo nome_arq
 /// Caso nao consiga ler do arquivo, cria mapa vazio
-Labirinto::Labirinto(const string& nome_arq)
+Labirinto::Labirinto(const string& nome_arq): numIndices(0), layout(LayoutMapa::LINHAS),
+    LB(0), TB(0)
 {
     ler(nome_arq);
 }
@@ -64,14 +203,24 @@ void Labirinto::clear()
 {
     // Esvazia o mapa de qualquer conteudo anterior
     NL = NC = 0;
-    mapa.clear();
+    paginas.clear();
+    celulas.clear();
+    numIndices = 0;
+    LB = TB = 0;
     // Apaga a origem e destino do caminho
     orig = dest = Coord();
+    caminho.clear();
+    hierarquia.reset();
+    janela = Janela();
+    NLArq = NCArq = 0;
 }
 
 /// Limpa o caminho anterior
 void Labirinto::limpaCaminho()
 {
+    // Soh ha celulas marcadas como CAMINHO depois de um caminho calculado (marcaCaminho)
+    if (caminho.empty()) return;
+    caminho.clear();
     if (!empty()) for (unsigned i=0; i<NL; i++) for (unsigned j=0; j<NC; j++)
             {
                 if (at(i,j) == EstadoCel::CAMINHO)
@@ -81,6 +230,15 @@ void Labirinto::limpaCaminho()
             }
 }
 
+/// Apaga a origem e o destino (e o caminho)
+void Labirinto::limpaOrigDest()
+{
+    limpaCaminho();
+    if (coordValida(orig)) set(orig, EstadoCel::LIVRE);
+    if (coordValida(dest)) set(dest, EstadoCel::LIVRE);
+    orig = dest = Coord();
+}
+
 /// Funcoes de consulta
 unsigned Labirinto::getNumLin() const
 {
@@ -106,7 +264,9 @@ Coord Labirinto::getDest() const
 /// Retorna o estado da celula correspondente ao i-j-esimo elemento do mapa
 EstadoCel Labirinto::at(unsigned i, unsigned j) const
 {
-    return mapa.at(NC*i+j);
+    unsigned idx = indice(i,j);
+    if (idx >= numIndices) throw out_of_range("Labirinto::at");
+    return atIndice(idx);
 }
 
 /// Retorna o estado da celula C
@@ -131,7 +291,21 @@ inline EstadoCel Labirinto::operator()(const Coord& C) const
 /// Funcao set de alteracao de valor
 void Labirinto::set(unsigned i, unsigned j, EstadoCel valor)
 {
-    mapa.at(NC*i+j) = valor;
+    unsigned idx = indice(i,j);
+    if (idx >= numIndices) throw out_of_range("Labirinto::set");
+    unsigned p = idx >> LOG_TAM_PAGINA;
+    if (paginas[p].use_count() > 1)
+    {
+        // Copia na escrita: as demais copias do mapa continuam com a pagina anterior
+        paginas[p] = make_shared<vector<EstadoCel> >(*paginas[p]);
+        celulas[p] = paginas[p]->data();
+    }
+    else
+    {
+        // Unico dono: as leituras de quem liberou a pagina acontecem antes desta escrita
+        atomic_thread_fence(memory_order_acquire);
+    }
+    celulas[p][idx & (TAM_PAGINA-1)] = valor;
 }
 
 void Labirinto::set(const Coord& C, EstadoCel valor)
@@ -139,10 +313,189 @@ void Labirinto::set(const Coord& C, EstadoCel valor)
     set(C.lin, C.col, valor);
 }
 
+/// Fixa as dimensoes e o layout e redimensiona o vetor mapa
+void Labirinto::dimensionar(unsigned numL, unsigned numC, LayoutMapa L)
+{
+    NL = numL;
+    NC = numC;
+    layout = L;
+
+    size_t tam = 0;
+    switch(layout)
+    {
+    case LayoutMapa::MORTON:
+    {
+        // Blocos de lado T: maior potencia de 2 <= min(NL, NC, TAM_MAX_BLOCO_MORTON)
+        // (cada dimensao eh completada com menos de T celulas)
+        for (TB=0; (2u << TB) <= min(min(NL, NC), unsigned(TAM_MAX_BLOCO_MORTON)); TB++);
+        const unsigned T = 1u << TB;
+        LB = (NC+T-1)/T;
+        tam = size_t((NL+T-1)/T)*LB*T*T;
+        break;
+    }
+    case LayoutMapa::BLOCOS:
+        LB = (NC+TAM_BLOCO-1)/TAM_BLOCO;
+        tam = size_t((NL+TAM_BLOCO-1)/TAM_BLOCO)*LB*TAM_BLOCO*TAM_BLOCO;
+        break;
+    case LayoutMapa::LINHAS:
+    default:
+        break;
+    }
+    if (layout == LayoutMapa::LINHAS || tam > FATOR_MAX_PREENCHIMENTO*size_t(NL)*NC)
+    {
+        // Layout recusado (preenchimento excessivo): linha a linha
+        layout = LayoutMapa::LINHAS;
+        LB = TB = 0;
+        tam = size_t(NL)*NC;
+    }
+    // Paginas novas (nao compartilhadas); a ultima pode ser menor
+    numIndices = tam;
+    paginas.resize((tam + TAM_PAGINA-1) >> LOG_TAM_PAGINA);
+    celulas.resize(paginas.size());
+    for (size_t p=0; p<paginas.size(); p++)
+    {
+        size_t tamPag = min(size_t(TAM_PAGINA), tam - (p << LOG_TAM_PAGINA));
+        paginas[p] = make_shared<vector<EstadoCel> >(tamPag, EstadoCel::OBSTACULO);
+        celulas[p] = paginas[p]->data();
+    }
+}
+
+/// Funcoes de indexacao, de acordo com o layout do mapa
+LayoutMapa Labirinto::getLayout() const
+{
+    return layout;
+}
+
+unsigned Labirinto::getNumIndices() const
+{
+    return numIndices;
+}
+
+/// Retorna o indice no vetor mapa da celula (i,j)
+unsigned Labirinto::indice(unsigned i, unsigned j) const
+{
+    switch(layout)
+    {
+    case LayoutMapa::MORTON:
+    {
+        const unsigned M = (1u << TB) - 1;
+        return (((i >> TB)*LB + (j >> TB)) << (2*TB)) | (espalhaBits(i & M) << 1) | espalhaBits(j & M);
+    }
+    case LayoutMapa::BLOCOS:
+        return ((i/TAM_BLOCO)*LB + j/TAM_BLOCO)*TAM_BLOCO*TAM_BLOCO +
+               (i%TAM_BLOCO)*TAM_BLOCO + j%TAM_BLOCO;
+    case LayoutMapa::LINHAS:
+    default:
+        break;
+    }
+    return NC*i+j;
+}
+
+unsigned Labirinto::indice(const Coord& C) const
+{
+    return indice(C.lin, C.col);
+}
+
+/// Retorna as coordenadas da celula de indice idx (inverso de "indice")
+Coord Labirinto::coordIndice(unsigned idx) const
+{
+    switch(layout)
+    {
+    case LayoutMapa::MORTON:
+    {
+        unsigned bloco = idx >> (2*TB);
+        unsigned resto = idx & ((1u << (2*TB)) - 1);
+        return Coord(((bloco/LB) << TB) | juntaBits(resto >> 1), ((bloco%LB) << TB) | juntaBits(resto));
+    }
+    case LayoutMapa::BLOCOS:
+    {
+        unsigned bloco = idx/(TAM_BLOCO*TAM_BLOCO);
+        unsigned resto = idx%(TAM_BLOCO*TAM_BLOCO);
+        return Coord((bloco/LB)*TAM_BLOCO + resto/TAM_BLOCO,
+                     (bloco%LB)*TAM_BLOCO + resto%TAM_BLOCO);
+    }
+    case LayoutMapa::LINHAS:
+    default:
+        break;
+    }
+    return Coord(idx/NC, idx%NC);
+}
+
+/// Retorna o indice da celula vizinha (dl e dc entre -1 e 1) da celula de indice idx
+/// Evita a conversao indice -> coordenadas -> indice
+unsigned Labirinto::indiceVizinho(unsigned idx, int dl, int dc) const
+{
+    switch(layout)
+    {
+    case LayoutMapa::MORTON:
+    {
+        // Bits de coluna e de linha dentro do bloco
+        const unsigned masc = (1u << (2*TB)) - 1;
+        const unsigned mc = MASC_MORTON_COL & masc, ml = MASC_MORTON_LIN & masc;
+        unsigned dentro = idx & masc;
+        // Na fronteira do bloco, passa pelas coordenadas
+        if ((dc > 0 && (dentro & mc) == mc) || (dc < 0 && (dentro & mc) == 0) ||
+                (dl > 0 && (dentro & ml) == ml) || (dl < 0 && (dentro & ml) == 0))
+        {
+            Coord C = coordIndice(idx);
+            return indice(C.lin+dl, C.col+dc);
+        }
+        // Soma/subtrai 1 somente nos bits de coluna (ou de linha): os bits da
+        // outra coordenada sao forcados a 1 (ou a 0) para propagar o "vai um"
+        if (dc > 0) dentro = (((dentro | ml) + 1) & mc) | (dentro & ml);
+        else if (dc < 0) dentro = (((dentro & mc) - 1) & mc) | (dentro & ml);
+        if (dl > 0) dentro = (((dentro | mc) + 2) & ml) | (dentro & mc);
+        else if (dl < 0) dentro = (((dentro & ml) - 2) & ml) | (dentro & mc);
+        return (idx & ~masc) | dentro;
+    }
+    case LayoutMapa::BLOCOS:
+    {
+        // Dentro do bloco, basta somar o deslocamento; na fronteira, pula para o bloco vizinho
+        unsigned j = idx%TAM_BLOCO;
+        unsigned i = (idx/TAM_BLOCO)%TAM_BLOCO;
+        if (dc > 0) idx += (j == TAM_BLOCO-1 ? TAM_BLOCO*TAM_BLOCO-(TAM_BLOCO-1) : 1);
+        else if (dc < 0) idx -= (j == 0 ? TAM_BLOCO*TAM_BLOCO-(TAM_BLOCO-1) : 1);
+        if (dl > 0) idx += (i == TAM_BLOCO-1 ? LB*TAM_BLOCO*TAM_BLOCO-TAM_BLOCO*(TAM_BLOCO-1) : TAM_BLOCO);
+        else if (dl < 0) idx -= (i == 0 ? LB*TAM_BLOCO*TAM_BLOCO-TAM_BLOCO*(TAM_BLOCO-1) : TAM_BLOCO);
+        return idx;
+    }
+    case LayoutMapa::LINHAS:
+    default:
+        break;
+    }
+    return idx + dl*int(NC) + dc;
+}
+
+/// Retorna o estado da celula de indice idx (sem teste de limites)
+EstadoCel Labirinto::atIndice(unsigned idx) const
+{
+    return celulas[idx >> LOG_TAM_PAGINA][idx & (TAM_PAGINA-1)];
+}
+
+/// Reorganiza as celulas do mapa de acordo com o novo layout
+void Labirinto::setLayout(LayoutMapa L)
+{
+    if (L == layout) return;
+
+    // Copia o conteudo atual linha a linha
+    vector<EstadoCel> prov(NL*NC);
+    for (unsigned i=0; i<NL; i++) for (unsigned j=0; j<NC; j++)
+        {
+            prov[NC*i+j] = at(i,j);
+        }
+
+    // Reorganiza
+    dimensionar(NL, NC, L);
+    for (unsigned i=0; i<NL; i++) for (unsigned j=0; j<NC; j++)
+        {
+            set(i,j, prov[NC*i+j]);
+        }
+}
+
 /// Testa se um mapa estah vazio
 bool Labirinto::empty() const
 {
-    return mapa.empty();
+    return numIndices == 0;
 }
 
 /// Testa se um mapa tem origem e destino definidos
@@ -230,51 +583,40 @@ bool Labirinto::setDestino(const Coord& C)
     return true;
 }
 
+/// Marca ou desmarca a celula C como obstaculo
+bool Labirinto::setObstaculo(const Coord& C, bool obst)
+{
+    if (!coordValida(C) || C==orig || C==dest) return false;
+
+    // Um caminho anterior e o pre-processamento podem deixar de ser validos
+    limpaCaminho();
+    hierarquia.reset();
+
+    set(C, obst ? EstadoCel::OBSTACULO : EstadoCel::LIVRE);
+    return true;
+}
+
 /// Imprime o mapa no console
+/// O desenho eh montado em um unico buffer e escrito de uma vez
 void Labirinto::imprimir() const
 {
     if (empty())
     {
-        cout << "+------------+" << endl;
-        cout << "| MAPA VAZIO |" << endl;
-        cout << "+------------+" << endl;
+        escreveConsole("+------------+\n"
+                       "| MAPA VAZIO |\n"
+                       "+------------+\n");
         return;
     }
 
-    unsigned i,j;
-
-    // Impressao do cabecalho
-    cout << "    ";
-    for (j=0; j<NC; j++)
-    {
-        cout << setfill('0') << setw(2) << j << setfill(' ') << setw(0) << ' ' ;
-    }
-    cout << endl;
-
-    cout << "   +";
-    for (j=0; j<NC; j++) cout << "--+" ;
-    cout << endl;
-
-    // Imprime as linhas
-    for (i=0; i<NL; i++)
-    {
-        cout << setfill('0') << setw(2) << i << setfill(' ') << setw(0) << " |" ;
-        for (j=0; j<NC; j++)
-        {
-            cout << estadoCel2string(at(i,j)) << '|' ;
-        }
-        cout << endl;
-
-        cout << "   +";
-        for (j=0; j<NC; j++) cout << "--+" ;
-        cout << endl;
-    }
+    string buf;
+    desenhaJanela(buf, *this, Janela(0, 0, NL, NC));
+    escreveConsole(buf);
 }
 
 /// Leh um mapa do arquivo nome_arq
 /// Caso nao consiga ler do arquivo, cria mapa vazio
 /// Retorna true em caso de leitura bem sucedida
-bool Labirinto::ler(const string& nome_arq)
+bool Labirinto::ler(const string& nome_arq, LayoutMapa L)
 {
     // Limpa o mapa
     clear();
@@ -286,34 +628,47 @@ bool Labirinto::ler(const string& nome_arq)
         return false;
     }
 
+    bool ok = ler(arq, L);
+    arq.close();
+    return ok;
+}
+
+/// Leh um mapa de uma stream
+bool Labirinto::ler(istream& I, LayoutMapa L)
+{
+    // Limpa o mapa
+    clear();
+
     string prov;
     int numL, numC;
     int valor;
 
     // Leh o cabecalho
-    arq >> prov >> numL >> numC;
-    if (prov != "LABIRINTO" ||
-            numL<ALTURA_MIN_MAPA || numL>ALTURA_MAX_MAPA ||
-            numC<LARGURA_MIN_MAPA || numC>LARGURA_MAX_MAPA)
+    I >> prov >> numL >> numC;
+    if (!I || prov != "LABIRINTO" ||
+            numL<ALTURA_MIN_MAPA || numL>int(alturaMax) ||
+            numC<LARGURA_MIN_MAPA || numC>int(larguraMax))
     {
-        arq.close();
         return false;
     }
 
     // Redimensiona o mapa
-    NL = numL;
-    NC = numC;
-    mapa.resize(NL*NC);
+    dimensionar(numL, numC, L);
 
-    // Leh as celulas do arquivo
+    // Leh as celulas
     for (unsigned i=0; i<NL; i++)
         for (unsigned j=0; j<NC; j++)
         {
-            arq >> valor;
+            I >> valor;
+            if (!I)
+            {
+                // Celulas faltando ou invalidas
+                clear();
+                return false;
+            }
             if (valor == 0) set(i,j,EstadoCel::OBSTACULO);
             else set(i,j,EstadoCel::LIVRE);
         }
-    arq.close();
     return true;
 }
 
@@ -331,98 +686,547 @@ bool Labirinto::salvar(const string& nome_arq) const
         return false;
     }
 
+    bool ok = salvar(arq);
+    arq.close();
+    return ok;
+}
+
+/// Salva um mapa em uma stream
+bool Labirinto::salvar(ostream& O) const
+{
+    // Testa o mapa
+    if (empty()) return false;
+
     // Salva o cabecalho
-    arq << "LABIRINTO " << NL << ' ' << NC << endl;
+    O << "LABIRINTO " << NL << ' ' << NC << endl;
 
     // Salva as celulas do mapa
     for (unsigned i=0; i<NL; i++)
     {
         for (unsigned j=0; j<NC; j++)
         {
-            if (at(i,j) == EstadoCel::OBSTACULO) arq << 0;
-            else arq << 1;
-            arq << ' ';
+            if (at(i,j) == EstadoCel::OBSTACULO) O << 0;
+            else O << 1;
+            O << ' ';
         }
-        arq << endl;
+        O << endl;
     }
+    return bool(O);
+}
 
-    arq.close();
-    return true;
+/* ******************** */
+/* LEITURA COM JANELA   */
+/* ******************** */
+
+/// Copia para este mapa a janela J do mapa completo M
+void Labirinto::copiaJanela(const Labirinto& M, const Janela& J, LayoutMapa L)
+{
+    dimensionar(J.numL, J.numC, L);
+    for (unsigned i=0; i<NL; i++) for (unsigned j=0; j<NC; j++)
+        {
+            if (M.at(J.lin+i, J.col+j) != EstadoCel::OBSTACULO) set(i,j,EstadoCel::LIVRE);
+        }
 }
 
-/// Gera um novo mapa aleatorio
-/// numL e numC sao as dimensoes do labirinto
-/// perc_obst eh o percentual de casas ocupadas no mapa. Se <=0, assume um valor aleatorio
-/// entre PERC_MIN_OBST e PERC_MAX_OBST
-/// Se os parametros forem incorretos, gera um mapa vazio
-/// Retorna true em caso de geracao bem sucedida (parametros corretos)
-bool Labirinto::gerar(unsigned numL, unsigned numC, double perc_obst)
+/// Leh somente a janela J de um mapa salvo no arquivo nome_arq
+bool Labirinto::ler(const string& nome_arq, const Janela& J, LayoutMapa L)
 {
     // Limpa o mapa
     clear();
 
-    // Inicializa a semente de geracao de numeros aleatorios
-    srand(time(nullptr));
-
-    // Calcula o percentual de obstaculos no mapa
-    if (perc_obst <= 0.0)
+    // Abre o arquivo
+    ifstream arq(nome_arq.c_str(), ios::binary);
+    if (!arq.is_open())
     {
-        perc_obst = PERC_MIN_OBST +
-                    (PERC_MAX_OBST-PERC_MIN_OBST)*(rand()/double(RAND_MAX));
+        return false;
     }
 
-    // Testa os parametros
-    if (numL<ALTURA_MIN_MAPA || numL>ALTURA_MAX_MAPA ||
-            numC<LARGURA_MIN_MAPA || numC>LARGURA_MAX_MAPA ||
-            perc_obst<PERC_MIN_OBST || perc_obst>PERC_MAX_OBST)
+    // O formato eh identificado pelos 4 primeiros bytes: "LABB" (BITS), "LABR" (RLE)
+    // ou "LABI" (texto, "LABIRINTO")
+    char ident[4] = {0, 0, 0, 0};
+    arq.read(ident, 4);
+    if (!arq || ident[0] != 'L' || ident[1] != 'A' || ident[2] != 'B')
     {
         return false;
     }
+    arq.seekg(0);
 
-    // Assume as dimensoes passadas como parametro
-    NL = numL;
-    NC = numC;
+    unsigned numL, numC;
+    Janela W;
+    bool direto = false;
+    if (ident[3] == 'B')
+    {
+        // BITS: cada linha ocupa bytesLinha bytes, a partir do fim do cabecalho
+        unsigned char cabec[TAM_CABEC_COMPACTO];
+        arq.read((char*)cabec, TAM_CABEC_COMPACTO);
+        numL = leU32(cabec+4);
+        numC = leU32(cabec+8);
+        unsigned bytesLinha = (numC+7)/8;
+        if (!arq || numL<ALTURA_MIN_MAPA || numL>alturaMax ||
+                numC<LARGURA_MIN_MAPA || numC>larguraMax ||
+                leU32(cabec+12) != numL*bytesLinha)
+        {
+            return false;
+        }
 
-    // Redimensiona o mapa
-    mapa.resize(NL*NC);
+        // Leh somente os bytes das colunas da janela, em cada linha da janela
+        W = ajustaJanela(J, numL, numC);
+        dimensionar(W.numL, W.numC, L);
+        unsigned b0 = W.col/8, b1 = (W.col+W.numC-1)/8;
+        vector<unsigned char> linha(b1-b0+1);
+        for (unsigned i=0; i<NL; i++)
+        {
+            arq.seekg(TAM_CABEC_COMPACTO + streamoff(W.lin+i)*bytesLinha + b0);
+            arq.read((char*)linha.data(), linha.size());
+            if (!arq)
+            {
+                clear();
+                return false;
+            }
+            for (unsigned j=0; j<NC; j++)
+            {
+                unsigned c = W.col+j;
+                if (linha[c/8-b0] & (1 << (c%8))) set(i,j,EstadoCel::LIVRE);
+            }
+        }
+        direto = true;
+    }
+    else if (ident[3] == 'I')
+    {
+        // Texto: leh o cabecalho
+        string prov;
+        int nL, nC;
+        arq >> prov >> nL >> nC;
+        if (prov != "LABIRINTO" ||
+                nL<ALTURA_MIN_MAPA || nL>int(alturaMax) ||
+                nC<LARGURA_MIN_MAPA || nC>int(larguraMax))
+        {
+            return false;
+        }
+        numL = nL;
+        numC = nC;
+
+        // As linhas escritas por "salvar" tem tamanho fixo: "d " para cada celula
+        // (mais um eventual '\r') e o fim de linha; confere a primeira e a ultima
+        arq.ignore(numeric_limits<streamsize>::max(), '\n');
+        streamoff inicio = arq.tellg();
+        string linha;
+        getline(arq, linha);
+        streamoff largura = linha.size()+1;
+        direto = (arq && (linha.size() == 2*numC || linha.size() == 2*numC+1));
+        if (direto)
+        {
+            arq.seekg(inicio + (numL-1)*largura);
+            getline(arq, linha);
+            direto = (arq && streamoff(linha.size()+1) == largura);
+        }
 
-    // Preenche o mapa
-    bool obstaculo;
-    for (unsigned i=0; i<NL; i++) for (unsigned j=0; j<NC; j++)
+        // Leh somente os caracteres das colunas da janela, em cada linha da janela
+        W = ajustaJanela(J, numL, numC);
+        if (direto) dimensionar(W.numL, W.numC, L);
+        string celulas(2*W.numC, ' ');
+        for (unsigned i=0; direto && i<NL; i++)
         {
-            obstaculo = (rand()/double(RAND_MAX) <= perc_obst);
-            if (obstaculo) set(i,j,EstadoCel::OBSTACULO);
-            else set(i,j,EstadoCel::LIVRE);
+            arq.seekg(inicio + streamoff(W.lin+i)*largura + 2*W.col);
+            arq.read(&celulas[0], celulas.size());
+            for (unsigned j=0; direto && j<NC; j++)
+            {
+                // Qualquer coisa diferente de um digito e um espaco: o arquivo nao tem o formato fixo
+                char c = celulas[2*j];
+                direto = (arq && c >= '0' && c <= '9' && celulas[2*j+1] == ' ');
+                if (c != '0') set(i,j,EstadoCel::LIVRE);
+            }
+        }
+    }
+    else if (ident[3] != 'R')
+    {
+        return false;
+    }
+    arq.close();
+
+    if (!direto)
+    {
+        // Arquivo sem acesso direto as linhas: leh por inteiro e recorta a janela
+        Labirinto M;
+        if (!(ident[3] == 'R' ? M.lerCompacto(nome_arq) : M.ler(nome_arq)))
+        {
+            clear();
+            return false;
         }
+        numL = M.NL;
+        numC = M.NC;
+        W = ajustaJanela(J, numL, numC);
+        copiaJanela(M, W, L);
+    }
+
+    janela = W;
+    NLArq = numL;
+    NCArq = numC;
     return true;
 }
 
-
-///Heuristica
-double Labirinto::Heuristica(const Coord& ori, const Coord& de) const
+/// Retorna a janela do arquivo contida no mapa
+Janela Labirinto::getJanela() const
 {
-    Coord D = abs(de - ori);
-    return (sqrt(2)*min(D.lin, D.col) + fabs(D.lin - D.col));
+    if (NLArq == 0) return Janela(0, 0, NL, NC);
+    return janela;
 }
 
-/// Calcula o caminho entre a origem e o destino do labirinto usando o algoritmo A*
-///
-/// Retorna o comprimento do caminho (<0 se nao existe)
-///
-/// O parametro NC retorna o numero de nos no caminho encontrado (profundidade da busca)
-/// O parametro NC retorna <0 caso nao exista caminho.
-///
-/// O parametro NA retorna o numero de nos em aberto ao termino do algoritmo A*
-/// O parametro NF retorna o numero de nos em fechado ao termino do algoritmo A*
-/// Mesmo quando nao existe caminho, esses parametros devem ser retornados
-double Labirinto::calculaCaminho(int& NC, int& NA, int& NF)
+/// Dimensoes do mapa completo no arquivo
+unsigned Labirinto::getNumLinArq() const
 {
-    if (empty() || !origDestDefinidos())
-    {
-        // Impossivel executar o algoritmo
-        NC = NA = NF = -1;
-        return -1.0;
-    }
+    return (NLArq == 0 ? NL : NLArq);
+}
+
+unsigned Labirinto::getNumColArq() const
+{
+    return (NLArq == 0 ? NC : NCArq);
+}
+
+/// Conversao entre as coordenadas no arquivo e neste mapa
+Coord Labirinto::paraLocal(const Coord& C) const
+{
+    return C - Coord(janela.lin, janela.col);
+}
+
+Coord Labirinto::paraArquivo(const Coord& C) const
+{
+    return C + Coord(janela.lin, janela.col);
+}
+
+/// Calcula o menor caminho entre Or e De lendo somente uma janela em torno delas
+double Labirinto::buscaComJanela(const string& nome_arq, const Coord& Or, const Coord& De,
+                                 vector<Coord>& pontos, unsigned margem, int* numLeituras)
+{
+    pontos.clear();
+    if (numLeituras != nullptr) *numLeituras = 0;
+    margem = max(margem, 1u);
+
+    while (true)
+    {
+        if (!ler(nome_arq, Janela::envolvente(Or, De, margem))) return -1.0;
+        if (numLeituras != nullptr) (*numLeituras)++;
+        if (!janela.contem(Or) || !janela.contem(De) ||
+                !celulaLivre(paraLocal(Or)) || !celulaLivre(paraLocal(De)))
+        {
+            // Celulas fora do mapa ou obstaculos: aumentar a janela nao adianta
+            return -1.0;
+        }
+
+        int NA, NF;
+        double comprimento = buscaCaminho(paraLocal(Or), paraLocal(De), pontos, NA, NF);
+
+        // Limite inferior do comprimento de um caminho que saia da janela: ele passa
+        // por alguma celula do anel em volta da janela
+        double limite = numeric_limits<double>::infinity();
+        int l0 = int(janela.lin)-1, l1 = janela.lin+janela.numL;
+        int c0 = int(janela.col)-1, c1 = janela.col+janela.numC;
+        auto considera = [&](int i, int j)
+        {
+            if (i < 0 || j < 0 || i >= int(NLArq) || j >= int(NCArq)) return;
+            Coord C(i,j);
+            limite = min(limite, Heuristica(Or,C) + Heuristica(C,De));
+        };
+        for (int i=l0; i<=l1; i++)
+        {
+            considera(i, c0);
+            considera(i, c1);
+        }
+        for (int j=c0; j<=c1; j++)
+        {
+            considera(l0, j);
+            considera(l1, j);
+        }
+
+        if (limite == numeric_limits<double>::infinity() ||
+                (comprimento >= 0.0 && comprimento <= limite + 1e-9))
+        {
+            // Nenhum caminho que saia da janela pode ser mais curto
+            for (Coord& C : pontos) C = paraArquivo(C);
+            return comprimento;
+        }
+        margem *= 2;
+    }
+}
+
+/* ******************** */
+/* CODIFICACAO COMPACTA */
+/* ******************** */
+
+/// Numero de bytes de um inteiro codificado como varint (7 bits por byte)
+static size_t tamanhoVarint(unsigned x)
+{
+    size_t n = 1;
+    while (x >= 0x80)
+    {
+        x >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/// Retorna o tamanho em bytes da codificacao compacta do mapa no formato F
+size_t Labirinto::tamanhoCompacto(FormatoCompacto F) const
+{
+    if (F == FormatoCompacto::BITS)
+    {
+        return TAM_CABEC_COMPACTO + size_t(NL)*((NC+7)/8);
+    }
+
+    // RLE: soma os tamanhos das sequencias de cada linha
+    size_t tam = TAM_CABEC_COMPACTO;
+    for (unsigned i=0; i<NL; i++)
+    {
+        bool livre = true;
+        unsigned cont = 0;
+        for (unsigned j=0; j<NC; j++)
+        {
+            if ((at(i,j) != EstadoCel::OBSTACULO) != livre)
+            {
+                tam += tamanhoVarint(cont);
+                livre = !livre;
+                cont = 0;
+            }
+            cont++;
+        }
+        tam += tamanhoVarint(cont);
+    }
+    return tam;
+}
+
+/// Escreve a codificacao compacta do mapa no formato F em buf
+size_t Labirinto::escreverCompacto(FormatoCompacto F, unsigned char* buf, size_t tam) const
+{
+    size_t total = tamanhoCompacto(F);
+    if (empty() || buf == nullptr || tam < total) return 0;
+
+    // Cabecalho
+    buf[0] = 'L';
+    buf[1] = 'A';
+    buf[2] = 'B';
+    buf[3] = (F == FormatoCompacto::BITS ? 'B' : 'R');
+    escreveU32(buf+4, NL);
+    escreveU32(buf+8, NC);
+    escreveU32(buf+12, total-TAM_CABEC_COMPACTO);
+
+    unsigned char* p = buf+TAM_CABEC_COMPACTO;
+    if (F == FormatoCompacto::BITS)
+    {
+        unsigned bytesLinha = (NC+7)/8;
+        fill(p, p+size_t(NL)*bytesLinha, 0);
+        for (unsigned i=0; i<NL; i++, p+=bytesLinha) for (unsigned j=0; j<NC; j++)
+            {
+                if (at(i,j) != EstadoCel::OBSTACULO) p[j/8] |= (1 << (j%8));
+            }
+        return total;
+    }
+
+    for (unsigned i=0; i<NL; i++)
+    {
+        bool livre = true;
+        unsigned cont = 0;
+        for (unsigned j=0; j<=NC; j++)
+        {
+            // Fim da linha ou mudanca de estado: escreve a sequencia
+            if (j == NC || (at(i,j) != EstadoCel::OBSTACULO) != livre)
+            {
+                for (; cont >= 0x80; cont >>= 7) *p++ = (cont & 0x7F) | 0x80;
+                *p++ = cont;
+                livre = !livre;
+                cont = 0;
+            }
+            cont++;
+        }
+    }
+    return total;
+}
+
+/// Leh um mapa da codificacao compacta em buf
+bool Labirinto::lerCompacto(const unsigned char* buf, size_t tam, LayoutMapa L)
+{
+    // Limpa o mapa (origem, destino, caminho e pre-processamento anteriores)
+    clear();
+
+    // Leh o cabecalho
+    if (buf == nullptr || tam < TAM_CABEC_COMPACTO ||
+            buf[0] != 'L' || buf[1] != 'A' || buf[2] != 'B' ||
+            (buf[3] != 'B' && buf[3] != 'R'))
+    {
+        return false;
+    }
+    unsigned numL = leU32(buf+4);
+    unsigned numC = leU32(buf+8);
+    size_t tamDados = leU32(buf+12);
+    if (numL<ALTURA_MIN_MAPA || numL>alturaMax ||
+            numC<LARGURA_MIN_MAPA || numC>larguraMax ||
+            tamDados > tam-TAM_CABEC_COMPACTO)
+    {
+        return false;
+    }
+
+    const unsigned char* p = buf+TAM_CABEC_COMPACTO;
+    const unsigned char* fim = p+tamDados;
+    if (buf[3] == 'B')
+    {
+        unsigned bytesLinha = (numC+7)/8;
+        if (tamDados != size_t(numL)*bytesLinha) return false;
+
+        // Redimensiona o mapa (todas as celulas comecam como obstaculos)
+        dimensionar(numL, numC, L);
+        for (unsigned i=0; i<NL; i++, p+=bytesLinha) for (unsigned j=0; j<NC; j++)
+            {
+                if (p[j/8] & (1 << (j%8))) set(i,j,EstadoCel::LIVRE);
+            }
+        return true;
+    }
+
+    dimensionar(numL, numC, L);
+    for (unsigned i=0; i<NL; i++)
+    {
+        bool livre = true;
+        unsigned j = 0;
+        while (true)
+        {
+            // Leh o comprimento da sequencia
+            unsigned cont = 0;
+            for (int desloc=0; ; desloc+=7)
+            {
+                if (p == fim || desloc > 28)
+                {
+                    clear();
+                    return false;
+                }
+                cont |= unsigned(*p & 0x7F) << desloc;
+                if (!(*p++ & 0x80)) break;
+            }
+            if (cont > NC-j)
+            {
+                clear();
+                return false;
+            }
+            for (unsigned k=0; k<cont; k++, j++)
+            {
+                if (livre) set(i,j,EstadoCel::LIVRE);
+            }
+            livre = !livre;
+            // A ultima sequencia da linha eh a que completa as NC colunas
+            if (j == NC) break;
+        }
+    }
+    if (p != fim)
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+/// Salva a codificacao compacta em um arquivo
+bool Labirinto::salvarCompacto(const string& nome_arq, FormatoCompacto F) const
+{
+    // Testa o mapa
+    if (empty()) return false;
+
+    vector<unsigned char> buf(tamanhoCompacto(F));
+    if (escreverCompacto(F, buf.data(), buf.size()) == 0) return false;
+
+    // Abre o arquivo
+    ofstream arq(nome_arq.c_str(), ios::binary);
+    if (!arq.is_open())
+    {
+        return false;
+    }
+    arq.write((const char*)buf.data(), buf.size());
+    arq.close();
+    return bool(arq);
+}
+
+/// Leh a codificacao compacta de um arquivo
+bool Labirinto::lerCompacto(const string& nome_arq, LayoutMapa L)
+{
+    // Limpa o mapa
+    clear();
+
+    // Abre o arquivo
+    ifstream arq(nome_arq.c_str(), ios::binary);
+    if (!arq.is_open())
+    {
+        return false;
+    }
+    vector<unsigned char> buf((istreambuf_iterator<char>(arq)), istreambuf_iterator<char>());
+    arq.close();
+    return lerCompacto(buf.data(), buf.size(), L);
+}
+
+/// Gera um novo mapa aleatorio
+/// numL e numC sao as dimensoes do labirinto
+/// perc_obst eh o percentual de casas ocupadas no mapa. Se <=0, assume um valor aleatorio
+/// entre PERC_MIN_OBST e PERC_MAX_OBST
+/// Se os parametros forem incorretos, gera um mapa vazio
+/// Retorna true em caso de geracao bem sucedida (parametros corretos)
+bool Labirinto::gerar(unsigned numL, unsigned numC, double perc_obst, LayoutMapa L, unsigned semente)
+{
+    // Limpa o mapa
+    clear();
+
+    // Inicializa a semente de geracao de numeros aleatorios
+    srand(semente != 0 ? semente : time(nullptr));
+
+    // Calcula o percentual de obstaculos no mapa
+    if (perc_obst <= 0.0)
+    {
+        perc_obst = PERC_MIN_OBST +
+                    (PERC_MAX_OBST-PERC_MIN_OBST)*(rand()/double(RAND_MAX));
+    }
+
+    // Testa os parametros
+    if (numL<ALTURA_MIN_MAPA || numL>alturaMax ||
+            numC<LARGURA_MIN_MAPA || numC>larguraMax ||
+            perc_obst<PERC_MIN_OBST || perc_obst>PERC_MAX_OBST)
+    {
+        return false;
+    }
+
+    // Assume as dimensoes passadas como parametro e redimensiona o mapa
+    dimensionar(numL, numC, L);
+
+    // Preenche o mapa
+    bool obstaculo;
+    for (unsigned i=0; i<NL; i++) for (unsigned j=0; j<NC; j++)
+        {
+            obstaculo = (rand()/double(RAND_MAX) <= perc_obst);
+            if (obstaculo) set(i,j,EstadoCel::OBSTACULO);
+            else set(i,j,EstadoCel::LIVRE);
+        }
+    return true;
+}
+
+
+///Heuristica
+double Labirinto::Heuristica(const Coord& ori, const Coord& de) const
+{
+    Coord D = abs(de - ori);
+    return (sqrt(2)*min(D.lin, D.col) + fabs(D.lin - D.col));
+}
+
+/// Calcula o caminho entre a origem e o destino do labirinto usando o algoritmo A*
+///
+/// Retorna o comprimento do caminho (<0 se nao existe)
+///
+/// O parametro NC retorna o numero de nos no caminho encontrado (profundidade da busca)
+/// O parametro NC retorna <0 caso nao exista caminho.
+///
+/// O parametro NA retorna o numero de nos em aberto ao termino do algoritmo A*
+/// O parametro NF retorna o numero de nos em fechado ao termino do algoritmo A*
+/// Mesmo quando nao existe caminho, esses parametros devem ser retornados
+double Labirinto::calculaCaminho(int& NC, int& NA, int& NF, ContextoBusca* ctx)
+{
+    if (empty() || !origDestDefinidos())
+    {
+        // Impossivel executar o algoritmo
+        NC = NA = NF = -1;
+        return -1.0;
+    }
 
     // Apaga um eventual caminho anterior
     limpaCaminho();
@@ -430,6 +1234,7 @@ double Labirinto::calculaCaminho(int& NC, int& NA, int& NF)
     // Testa se origem igual a destino
     if (orig==dest)
     {
+        caminho.push_back(orig);
         // Caminho tem profundidade nula
         NC = 0;
         // Algoritmo de busca nao gerou nenhum noh
@@ -438,117 +1243,500 @@ double Labirinto::calculaCaminho(int& NC, int& NA, int& NF)
         return 0.0;
     }
 
-    list<Noh> Aberto;
-    list<Noh> Fechado;
-    list<Noh>::iterator oldA;
-    list<Noh>::iterator oldF;
-    //list<Noh>::iterator old;  // cria um iterador para lista de Noh
+    double comprimento = buscaCaminho(orig, dest, caminho, NA, NF, nullptr, ctx);
+    if (comprimento < 0.0)
+    {
+        NC = -1;
+        return comprimento;
+    }
+    NC = caminho.size()-1;
+    marcaCaminho();
+    return comprimento;
+}
+
+/// Percorre o segmento A->B com o algoritmo de Bresenham, testando cada passo
+/// com as mesmas regras de movimentoValido
+/// Os testes sao feitos diretamente sobre os indices do mapa: todas as celulas
+/// testadas estao no retangulo entre A e B, logo dentro do mapa
+bool Labirinto::percorreSegmento(const Coord& A, const Coord& B, vector<Coord>* celulas) const
+{
+    if (!celulaLivre(A) || !celulaLivre(B)) return false;
 
-    Coord prox;
-    Coord dir;
+    Coord D = abs(B-A);
+    int passoL = (B.lin > A.lin ? 1 : -1);
+    int passoC = (B.col > A.col ? 1 : -1);
+    int erro = D.col - D.lin;
+
+    Coord C = A;
+    unsigned idx = indice(A);
+    while (C != B)
+    {
+        int dl = 0, dc = 0;
+        int erro2 = 2*erro;
+        if (erro2 > -D.lin)
+        {
+            erro -= D.lin;
+            dc = passoC;
+        }
+        if (erro2 < D.col)
+        {
+            erro += D.col;
+            dl = passoL;
+        }
+
+        if (atIndice(indiceVizinho(idx,dl,dc)) == EstadoCel::OBSTACULO) return false;
+        // Nao pode mover em diagonal se colidir com alguma quina
+        if (dl != 0 && dc != 0)
+        {
+            if (atIndice(indiceVizinho(idx,dl,0)) == EstadoCel::OBSTACULO) return false;
+            if (atIndice(indiceVizinho(idx,0,dc)) == EstadoCel::OBSTACULO) return false;
+        }
+
+        idx = indiceVizinho(idx,dl,dc);
+        C = C + Coord(dl,dc);
+        if (celulas != nullptr) celulas->push_back(C);
+    }
+    return true;
+}
 
-    Noh suc;
-    Noh atual;
+/// Testa se existe linha de visada entre as celulas A e B
+bool Labirinto::linhaDeVisada(const Coord& A, const Coord& B) const
+{
+    return percorreSegmento(A, B, nullptr);
+}
 
-    atual.pos = orig;
-    atual.ant = Coord();
-    atual.g = 0.0;
-    atual.h = Heuristica(orig,dest);
+/// Retorna os pontos do ultimo caminho calculado
+const vector<Coord>& Labirinto::getCaminho() const
+{
+    return caminho;
+}
+
+/// Marca como CAMINHO as celulas dos segmentos entre os pontos de "caminho"
+void Labirinto::marcaCaminho()
+{
+    vector<Coord> celulas;
+    for (unsigned k=1; k<caminho.size(); k++)
+    {
+        percorreSegmento(caminho[k-1], caminho[k], &celulas);
+    }
+    for (const Coord& C : celulas)
+    {
+        if (C != orig && C != dest) set(C, EstadoCel::CAMINHO);
+    }
+}
+
+/// Suaviza o ultimo caminho calculado ("puxando o barbante")
+/// A partir de cada ponto fixado (ancora), avanca enquanto houver linha de visada
+/// entre a ancora e o ponto seguinte do caminho original
+double Labirinto::suavizaCaminho()
+{
+    if (caminho.empty()) return -1.0;
+
+    vector<Coord> pontos(1, caminho.front());
+    for (unsigned k=1; k+1<caminho.size(); k++)
+    {
+        if (!linhaDeVisada(pontos.back(), caminho[k+1])) pontos.push_back(caminho[k]);
+    }
+    if (caminho.size() > 1) pontos.push_back(caminho.back());
+
+    // Refaz a marcacao do caminho no mapa
+    limpaCaminho();
+    caminho = pontos;
+    marcaCaminho();
 
-    Aberto.push_front(atual);
     double comprimento = 0.0;
+    for (unsigned k=1; k<caminho.size(); k++)
+    {
+        comprimento += norm(caminho[k]-caminho[k-1]);
+    }
+    return comprimento;
+}
 
-    // percorre o conteiner
-    do
+/// Calcula o caminho entre Or e De usando o algoritmo A*, sem alterar o mapa
+double Labirinto::buscaCaminho(const Coord& Or, const Coord& De, vector<Coord>& pontos,
+                               int& NA, int& NF, const Interrupcao* I, ContextoBusca* ctx) const
+{
+    pontos.clear();
+    if (!celulaLivre(Or) || !celulaLivre(De))
+    {
+        // Impossivel executar o algoritmo
+        NA = NF = -1;
+        return -1.0;
+    }
+
+    unsigned alvo;
+    return buscaAlvos(vector<unsigned>(1, indice(Or)), vector<unsigned>(1, indice(De)),
+                      pontos, alvo, NA, NF, I, ctx);
+}
+
+/// Calcula o caminho de alguma das origens ao destino mais proximo, sem alterar o mapa
+double Labirinto::buscaMaisProximo(const vector<Coord>& origens, const vector<Coord>& destinos,
+                                   vector<Coord>& pontos, int& alvo, int& NA, int& NF,
+                                   const Interrupcao* I, ContextoBusca* ctx) const
+{
+    pontos.clear();
+    alvo = -1;
+
+    // Descarta as celulas invalidas e as repetidas
+    vector<unsigned> iOrigens, iAlvos;
+    for (const Coord& C : origens) if (celulaLivre(C)) iOrigens.push_back(indice(C));
+    for (const Coord& C : destinos) if (celulaLivre(C)) iAlvos.push_back(indice(C));
+    sort(iAlvos.begin(), iAlvos.end());
+    iAlvos.erase(unique(iAlvos.begin(), iAlvos.end()), iAlvos.end());
+    if (iOrigens.empty() || iAlvos.empty())
     {
-        // Atualiza atual com o Noh de
-        // menor custo (o 1) de Aberto
-        atual = Aberto.front();
-        // Remove o 1 Noh de Aberto
-        Aberto.pop_front();
-        // Insere o Noh em Fechado
-        Fechado.push_front(atual);
+        // Impossivel executar o algoritmo
+        NA = NF = -1;
+        return -1.0;
+    }
 
-        if(atual.pos != dest)
+    unsigned iAlvo;
+    double comprimento = buscaAlvos(iOrigens, iAlvos, pontos, iAlvo, NA, NF, I, ctx);
+    if (comprimento >= 0.0)
+    {
+        // Posicao (a primeira, se repetido) do destino alcancado na lista original
+        Coord De = coordIndice(iAlvo);
+        alvo = find(destinos.begin(), destinos.end(), De) - destinos.begin();
+    }
+    return comprimento;
+}
+
+/// Algoritmo A* de varias origens para o mais proximo de varios alvos
+/// Os nos sao registros de 16 bytes alocados na arena do contexto de busca; a
+/// tabela celula -> registro do contexto faz o papel das listas Aberto e Fechado
+/// A heuristica eh a menor distancia octil aos alvos (consistente, como cada uma delas)
+/// ou zero (Dijkstra) se houver mais de MAX_ALVOS_HEURISTICA alvos
+double Labirinto::buscaAlvos(const vector<unsigned>& origens, const vector<unsigned>& alvos,
+                             vector<Coord>& pontos, unsigned& alvo, int& NA, int& NF,
+                             const Interrupcao* I, ContextoBusca* ctx) const
+{
+    pontos.clear();
+
+    // Sem contexto fornecido, usa um contexto soh para esta consulta
+    ContextoBusca local;
+    ContextoBusca& C = (ctx != nullptr ? *ctx : local);
+
+    vector<Coord> coordAlvos;
+    if (alvos.size() <= MAX_ALVOS_HEURISTICA)
+    {
+        for (unsigned k : alvos) coordAlvos.push_back(coordIndice(k));
+    }
+    auto heuristica = [this, &coordAlvos](const Coord& pos) -> double
+    {
+        double h = coordAlvos.empty() ? 0.0 : numeric_limits<double>::infinity();
+        for (const Coord& A : coordAlvos) h = min(h, Heuristica(pos, A));
+        return h;
+    };
+
+    const double RAIZ2 = sqrt(2.0);
+    NA = NF = 0;
+    if (!C.iniciar(getNumIndices()))
+    {
+        C.terminar();
+        return COMPR_SEM_MEMORIA;
+    }
+    // O registro de cada origem eh pai de si mesmo
+    for (unsigned k : origens)
+    {
+        if (C.corrente(k) != nullptr) continue;
+        if (!C.gerar(k, C.getNumRegistros(), 0, 0, heuristica(coordIndice(k))))
+        {
+            C.terminar();
+            return COMPR_SEM_MEMORIA;
+        }
+        NA++;
+    }
+
+    Coord dir;
+    unsigned atual;
+    while (C.retirar(atual))
+    {
+        C.fechar(atual);
+        NA--;
+        NF++;
+        const RegistroNoh& R = C[atual];
+
+        if (binary_search(alvos.begin(), alvos.end(), R.cel))
+        {
+            // Monta o caminho do alvo para a origem
+            unsigned k = atual;
+            pontos.push_back(coordIndice(C[k].cel));
+            while ((C[k].pai & ~NOH_FECHADO) != k)
+            {
+                k = (C[k].pai & ~NOH_FECHADO);
+                pontos.push_back(coordIndice(C[k].cel));
+            }
+            reverse(pontos.begin(), pontos.end());
+            alvo = R.cel;
+            C.terminar();
+            return R.getG();
+        }
+
+        // Interrupcao cooperativa
+        if (I != nullptr && (I->periodo <= 1 || NF%I->periodo == 0) && I->interromper())
         {
-            for (dir.lin = -1; dir.lin< 2; dir.lin++)
+            C.terminar();
+            return COMPR_INTERROMPIDA;
+        }
+
+        Coord pos = coordIndice(R.cel);
+        for (dir.lin = -1; dir.lin < 2; dir.lin++) for (dir.col = -1; dir.col < 2; dir.col++)
             {
-                for(dir.col = -1; dir.col< 2; dir.col++)
+                Coord prox = pos + dir;
+                if (dir == Coord(0,0) || !movimentoValido(pos, prox)) continue;
+                unsigned iProx = indice(prox);
+
+                bool diagonal = (dir.lin != 0 && dir.col != 0);
+                unsigned retos = R.retos + (diagonal ? 0 : 1);
+                unsigned diagonais = R.diagonais + (diagonal ? 1 : 0);
+                double custo = retos + diagonais*RAIZ2;
+
+                const RegistroNoh* P = C.corrente(iProx);
+                if (P != nullptr)
                 {
-                    if(dir != Coord(0,0) )
-                    {
-                        prox = atual.pos + dir;
-
-                        if(movimentoValido(atual.pos, prox))
-                        {
-                            suc.pos = prox;
-                            suc.ant = atual.pos;
-                            suc.g = atual.g + norm(dir);
-                            suc.h = Heuristica(suc.pos,dest);
-
-                            oldF = find(Fechado.begin(),Fechado.end(),suc.pos);
-
-                            if(oldF != Fechado.end())
-                            {
-                                if(suc.getCost() < oldF->getCost())
-                                {
-                                    Fechado.erase(oldF);
-                                    oldF = Fechado.end();
-                                }
-                            }
-                            if(oldF == Fechado.end())
-                            {
-                                oldA = find(Aberto.begin(),Aberto.end(),suc.pos);
-
-                                if(oldA != Aberto.end())
-                                {
-
-                                    if(suc.getCost() < oldA->getCost())
-                                    {
-                                        Aberto.erase(oldA);
-                                        oldA = Aberto.end();
-                                    }
-
-                                }
-                            }
-                            if(oldF == Fechado.end() && oldA == Aberto.end())
-                            {
-                                maior_que mqn(suc);
-                                oldA = find_if(Aberto.begin(),Aberto.end(),mqn);
-                                Aberto.insert(oldA,suc);
-
-                            }
-                        }
-                    }
+                    if ((P->pai & NOH_FECHADO) || custo >= P->getG()) continue;
+                }
+                else NA++;
+
+                if (!C.gerar(iProx, atual, retos, diagonais, custo + heuristica(prox)))
+                {
+                    C.terminar();
+                    return COMPR_SEM_MEMORIA;
                 }
             }
-        }
-        //cout<<"debug"<<endl;
     }
-    while((atual.pos != dest) && !Aberto.empty());
+    C.terminar();
+    return -1.0;
+}
 
-    if(atual.pos != dest)
+/// Calcula o caminho da origem ao destino mais proximo entre "destinos"
+double Labirinto::calculaCaminhoMaisProximo(const vector<Coord>& destinos, int& NC, int& NA, int& NF,
+        ContextoBusca* ctx)
+{
+    if (empty() || !coordValida(orig))
+    {
+        // Impossivel executar o algoritmo
+        NC = NA = NF = -1;
+        return -1.0;
+    }
+
+    // Apaga um eventual caminho anterior
+    limpaCaminho();
+
+    int alvo;
+    vector<Coord> pontos;
+    double comprimento = buscaMaisProximo(vector<Coord>(1, orig), destinos, pontos, alvo, NA, NF,
+                                          nullptr, ctx);
+    if (comprimento < 0.0)
     {
         NC = -1;
-        NF = Fechado.size();
-        NA = Aberto.size();
-        return -1;
+        return comprimento;
     }
-    else
+    // O destino mais proximo passa a ser o destino do labirinto
+    // (se for a propria origem, setDestino apagaria a marca da origem no mapa)
+    if (destinos[alvo] != orig) setDestino(destinos[alvo]);
+    caminho = pontos;
+    NC = caminho.size()-1;
+    marcaCaminho();
+    return comprimento;
+}
+
+/// Algoritmo Theta* (ou Lazy Theta*) entre Or e De
+/// Os nos sao identificados pelo indice da celula no mapa
+/// Theta*: ao gerar um sucessor, tenta ligar diretamente ao pai do noh atual,
+/// se houver linha de visada
+/// Lazy Theta*: supoe que ha linha de visada ao gerar e soh testa ao expandir;
+/// se nao houver, escolhe o melhor vizinho jah fechado como pai
+double Labirinto::buscaTheta(const Coord& Or, const Coord& De, bool lazy,
+                             vector<Coord>& pontos, int& NA, int& NF) const
+{
+    const double INF = numeric_limits<double>::infinity();
+    const unsigned N = getNumIndices();
+
+    vector<double> g(N, INF);
+    vector<unsigned> pai(N, N);
+    vector<bool> fechado(N, false);
+
+    // Fila de prioridade (menor custo primeiro) de pares (custo, indice)
+    // Entradas desatualizadas sao descartadas ao sair da fila
+    typedef pair<double,unsigned> Entrada;
+    priority_queue<Entrada, vector<Entrada>, greater<Entrada> > Aberto;
+
+    unsigned iOr = indice(Or), iDe = indice(De);
+    g[iOr] = 0.0;
+    pai[iOr] = iOr;
+    Aberto.push(Entrada(norm(De-Or), iOr));
+    NA = 1;
+    NF = 0;
+
+    pontos.clear();
+    Coord dir;
+    while (!Aberto.empty())
     {
-        comprimento = atual.g;
-        NC = 1;
-        while(atual.ant != orig)
+        unsigned atual = Aberto.top().second;
+        Aberto.pop();
+        if (fechado[atual]) continue;
+        fechado[atual] = true;
+        NA--;
+        NF++;
+        Coord pos = coordIndice(atual);
+
+        // Lazy Theta*: confirma a linha de visada com o pai
+        if (lazy && !linhaDeVisada(coordIndice(pai[atual]), pos))
+        {
+            g[atual] = INF;
+            for (dir.lin = -1; dir.lin < 2; dir.lin++) for (dir.col = -1; dir.col < 2; dir.col++)
+                {
+                    Coord viz = pos + dir;
+                    if (dir == Coord(0,0) || !movimentoValido(viz, pos)) continue;
+                    unsigned iViz = indice(viz);
+                    if (fechado[iViz] && g[iViz] + norm(dir) < g[atual])
+                    {
+                        g[atual] = g[iViz] + norm(dir);
+                        pai[atual] = iViz;
+                    }
+                }
+        }
+
+        if (atual == iDe)
         {
-            set(atual.ant, EstadoCel::CAMINHO);
-            oldF = find(Fechado.begin(),Fechado.end(),atual.ant);
-            atual = *oldF;
-            NC++;
+            // Monta o caminho do destino para a origem
+            for (unsigned k=atual; k!=iOr; k=pai[k]) pontos.push_back(coordIndice(k));
+            pontos.push_back(Or);
+            reverse(pontos.begin(), pontos.end());
+            return g[atual];
         }
-        NF = Fechado.size();
-        NA = Aberto.size();
-        return comprimento;
 
+        Coord posPai = coordIndice(pai[atual]);
+        for (dir.lin = -1; dir.lin < 2; dir.lin++) for (dir.col = -1; dir.col < 2; dir.col++)
+            {
+                Coord prox = pos + dir;
+                if (dir == Coord(0,0) || !movimentoValido(pos, prox)) continue;
+                unsigned iProx = indice(prox);
+                if (fechado[iProx]) continue;
+
+                // Caminho 2 (ligado ao pai do atual) ou caminho 1 (ligado ao atual)
+                double custo;
+                unsigned novoPai;
+                if (lazy || linhaDeVisada(posPai, prox))
+                {
+                    custo = g[pai[atual]] + norm(prox-posPai);
+                    novoPai = pai[atual];
+                }
+                else
+                {
+                    custo = g[atual] + norm(dir);
+                    novoPai = atual;
+                }
+
+                if (custo < g[iProx])
+                {
+                    if (g[iProx] == INF) NA++;
+                    g[iProx] = custo;
+                    pai[iProx] = novoPai;
+                    Aberto.push(Entrada(custo + norm(De-prox), iProx));
+                }
+            }
     }
+    return -1.0;
+}
 
+/// Calcula um caminho em qualquer angulo entre a origem e o destino
+double Labirinto::calculaCaminhoTheta(int& NC, int& NA, int& NF, bool lazy)
+{
+    if (empty() || !origDestDefinidos())
+    {
+        // Impossivel executar o algoritmo
+        NC = NA = NF = -1;
+        return -1.0;
+    }
+
+    // Apaga um eventual caminho anterior
+    limpaCaminho();
+
+    double comprimento = buscaTheta(orig, dest, lazy, caminho, NA, NF);
+    if (comprimento < 0.0)
+    {
+        NC = -1;
+        return -1.0;
+    }
+    NC = caminho.size()-1;
+    marcaCaminho();
+    return comprimento;
+}
+
+/* ********************** */
+/* PRE-PROCESSAMENTO      */
+/* ********************** */
+
+/// Pre-processa o mapa (hierarquia de contracao)
+bool Labirinto::preprocessar()
+{
+    shared_ptr<HierarquiaContracao> H = make_shared<HierarquiaContracao>();
+    if (!H->construir(*this)) return false;
+    hierarquia = H;
+    return true;
+}
+
+/// Testa se o mapa foi pre-processado
+bool Labirinto::preprocessado() const
+{
+    return hierarquia != nullptr;
+}
+
+/// Retorna o pre-processamento
+shared_ptr<const HierarquiaContracao> Labirinto::getPreprocessamento() const
+{
+    return hierarquia;
+}
+
+/// Salva o pre-processamento ao lado do arquivo do mapa
+bool Labirinto::salvarPreprocessamento(const string& nome_arq) const
+{
+    if (!preprocessado()) return false;
+    return hierarquia->salvar(nome_arq + EXTENSAO_PREPROCESSAMENTO);
+}
+
+/// Leh o pre-processamento salvo ao lado do arquivo do mapa
+bool Labirinto::lerPreprocessamento(const string& nome_arq)
+{
+    shared_ptr<HierarquiaContracao> H = make_shared<HierarquiaContracao>();
+    if (!H->ler(nome_arq + EXTENSAO_PREPROCESSAMENTO, *this)) return false;
+    hierarquia = H;
+    return true;
+}
+
+/// Calcula o menor caminho entre Or e De usando o pre-processamento
+double Labirinto::buscaPreprocessada(const Coord& Or, const Coord& De, vector<Coord>& pontos) const
+{
+    if (!preprocessado())
+    {
+        pontos.clear();
+        return -1.0;
+    }
+    return hierarquia->consultar(Or, De, pontos);
+}
+
+/// Calcula o caminho entre a origem e o destino usando o pre-processamento
+double Labirinto::calculaCaminhoPreprocessado(int& NC)
+{
+    if (empty() || !origDestDefinidos() || !preprocessado())
+    {
+        // Impossivel executar a consulta
+        NC = -1;
+        return -1.0;
+    }
+
+    // Apaga um eventual caminho anterior
+    limpaCaminho();
+
+    double comprimento = buscaPreprocessada(orig, dest, caminho);
+    if (comprimento < 0.0)
+    {
+        NC = -1;
+        return -1.0;
+    }
+    NC = caminho.size()-1;
+    marcaCaminho();
+    return comprimento;
 }
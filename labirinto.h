@@ -2,6 +2,9 @@
 #define _LABIRINTO_H_
 
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include "coord.h"
 
 using namespace std;
@@ -14,11 +17,39 @@ using namespace std;
 #define ALTURA_MED_MAPA 10
 #define ALTURA_MAX_MAPA 20
 
+/// Dimensoes maximas dos mapas nos modos de linha de comando (benchmarks, servicos etc.)
+/// Valem somente depois de Labirinto::setLimites(ALTURA_MAX_BENCH, LARGURA_MAX_BENCH)
+#define LARGURA_MAX_BENCH 10000
+#define ALTURA_MAX_BENCH 10000
+
 #define PERC_MIN_OBST 0.05
 #define PERC_MAX_OBST 0.50
 
+/// Comprimento retornado por uma busca interrompida (cancelada ou com prazo esgotado)
+#define COMPR_INTERROMPIDA -2.0
+/// Comprimento retornado por uma busca que ultrapassou o limite de memoria do seu contexto
+#define COMPR_SEM_MEMORIA -3.0
+
+/// Numero maximo de destinos para os quais a busca pelo destino mais proximo usa como
+/// heuristica a menor distancia octil aos destinos; com mais destinos, calcular essa
+/// heuristica custa mais do que ela economiza, e a busca vira um Dijkstra
+#define MAX_ALVOS_HEURISTICA 16
+
+/// Lado dos blocos quadrados do layout LayoutMapa::BLOCOS
+/// Com 1 byte por celula, um bloco 8x8 ocupa exatamente uma linha de cache (64 bytes)
+#define TAM_BLOCO 8
+/// Lado maximo (potencia de 2) dos blocos do layout LayoutMapa::MORTON
+#define TAM_MAX_BLOCO_MORTON 64
+/// Um layout cujo preenchimento multiplique o numero de celulas por mais que isso eh recusado
+#define FATOR_MAX_PREENCHIMENTO 4
+/// log2 do numero de celulas das paginas do vetor mapa (4096 celulas, 4KB)
+/// Com o lado maximo, um bloco do layout MORTON ocupa exatamente uma pagina
+#define LOG_TAM_PAGINA 12
+#define TAM_PAGINA (1u << LOG_TAM_PAGINA)
+
 /// Os possiveis estados de uma celula do mapa
-enum class EstadoCel
+/// Ocupa 1 byte, para que os blocos do layout BLOCOS caibam em uma linha de cache
+enum class EstadoCel : unsigned char
 {
     LIVRE,
     OBSTACULO,
@@ -30,8 +61,87 @@ enum class EstadoCel
 // Funcao para converter um estado de celula em uma string que o represente
 string estadoCel2string(EstadoCel E);
 
+/// As possiveis organizacoes das celulas do mapa na memoria
+/// LINHAS = linha a linha (indice NC*i+j)
+/// MORTON = blocos quadrados armazenados consecutivamente, na ordem Z dentro de cada bloco
+///          (os bits de i e j sao intercalados); o lado dos blocos eh a maior potencia de 2
+///          que nao passa da menor dimensao do mapa nem de TAM_MAX_BLOCO_MORTON, de modo que
+///          o preenchimento de cada dimensao eh sempre menor que ela
+/// BLOCOS = blocos TAM_BLOCO x TAM_BLOCO armazenados consecutivamente,
+///          linha a linha dentro de cada bloco
+/// Nos layouts MORTON e BLOCOS, as celulas de preenchimento (fora do mapa) sao obstaculos
+/// Se o preenchimento passar de FATOR_MAX_PREENCHIMENTO vezes o mapa, o layout LINHAS eh usado
+enum class LayoutMapa
+{
+    LINHAS,
+    MORTON,
+    BLOCOS
+};
+
+// Funcao para converter um layout em uma string que o represente
+string layout2string(LayoutMapa L);
+
+/// Nome de um arquivo temporario exclusivo: base + "." + numero do processo + "." + contador
+/// (varios processos ou threads podem criar arquivos temporarios no mesmo diretorio)
+string nomeTemporario(const string& base);
+
+/// Os formatos da codificacao binaria compacta de um mapa
+/// BITS = 1 bit por celula (1=livre), linha a linha, cada linha comecando em um novo byte
+/// RLE  = comprimentos (varint) das sequencias alternadas de celulas livres e obstaculos,
+///        linha a linha, comecando por uma sequencia (possivelmente vazia) de livres
+/// A codificacao comeca por um cabecalho de TAM_CABEC_COMPACTO bytes:
+/// 'L' 'A' 'B' <formato> NL NC <tamanho dos dados> (inteiros de 32 bits little-endian)
+enum class FormatoCompacto
+{
+    BITS,
+    RLE
+};
+
+#define TAM_CABEC_COMPACTO 16
+
+/// Extensao acrescentada ao nome do arquivo do mapa para o arquivo do pre-processamento
+#define EXTENSAO_PREPROCESSAMENTO ".ch"
+
+// Hierarquia de contracao (pre-processamento de um mapa estatico), definida em contracao.h
+class HierarquiaContracao;
+// Contexto (memoria) de uma busca A*, definido em arena.h
+class ContextoBusca;
 
 
+
+/// Controle de interrupcao cooperativa de uma busca
+/// A busca consulta "interromper" a cada "periodo" nos expandidos
+struct Interrupcao
+{
+    /// Sinalizador de cancelamento (nullptr = a busca nao pode ser cancelada)
+    const atomic<bool>* cancelada;
+    /// Prazo para o termino da busca (soh vale se temPrazo for true)
+    chrono::steady_clock::time_point prazo;
+    bool temPrazo;
+    /// Numero de nos expandidos entre dois testes (0 ou 1: testa a cada noh)
+    unsigned periodo;
+
+    Interrupcao();
+
+    /// Testa se a busca deve ser interrompida
+    bool interromper() const;
+};
+
+/// Uma janela (retangulo) do mapa: as linhas lin ... lin+numL-1 e as colunas col ... col+numC-1
+struct Janela
+{
+    unsigned lin, col, numL, numC;
+
+    Janela();
+    Janela(unsigned l, unsigned c, unsigned nL, unsigned nC);
+
+    /// Menor janela que contem A e B, acrescida de "margem" celulas em cada direcao
+    /// (sem ultrapassar as linhas e colunas de indice 0)
+    static Janela envolvente(const Coord& A, const Coord& B, unsigned margem);
+    /// Testa se a janela contem a celula C
+    bool contem(const Coord& C) const;
+};
+
 /// A classe que armazena o mapa e os metodos de resolucao de labirintos
 class Labirinto
 {
@@ -48,15 +158,75 @@ private:
     /// | 00 01 02 03 |
     /// | 10 11 12 13 |
     /// | 20 21 22 23 | -> 00 01 02 03 10 11 12 13 20 21 22 23
-    vector<EstadoCel> mapa;
+    /// Essa eh a organizacao do layout LINHAS; os demais layouts (MORTON e BLOCOS)
+    /// usam outra transformacao, calculada pelo metodo "indice"
+    /// O vetor eh dividido em paginas de TAM_PAGINA indices consecutivos, compartilhadas
+    /// (com contagem de referencias) pelas copias do mapa: uma copia soh duplica uma pagina
+    /// quando altera uma celula dela (copia na escrita, ver "set")
+    vector<shared_ptr<vector<EstadoCel> > > paginas;
+    /// O endereco das celulas de cada pagina (para a leitura nao passar pelo shared_ptr)
+    vector<EstadoCel*> celulas;
+    /// O tamanho do vetor mapa (soma dos tamanhos das paginas)
+    unsigned numIndices;
+
+    /// A organizacao das celulas no vetor mapa
+    LayoutMapa layout;
+    /// Layouts MORTON e BLOCOS: numero de blocos em cada linha de blocos
+    unsigned LB;
+    /// Layout MORTON: log2 do lado dos blocos
+    unsigned TB;
+
+    /// Dimensoes maximas aceitas por ler e gerar (iguais para todos os mapas)
+    static unsigned alturaMax, larguraMax;
 
     /// A origem e o destino do caminho
     Coord orig, dest;
 
+    /// Os pontos do ultimo caminho calculado, de orig a dest
+    /// No A* sao todas as celulas do caminho; no Theta* e apos a suavizacao,
+    /// somente os vertices (pontos de mudanca de direcao)
+    vector<Coord> caminho;
+
+    /// O pre-processamento do mapa (nullptr se nao foi feito)
+    /// Eh descartado quando os obstaculos mudam
+    shared_ptr<const HierarquiaContracao> hierarquia;
+
+    /// Mapa lido parcialmente (ler com janela): a janela do arquivo que foi lida
+    /// e as dimensoes do mapa completo no arquivo (NLArq = 0 para um mapa completo)
+    /// A celula (i,j) deste mapa eh a celula (janela.lin+i, janela.col+j) do arquivo
+    Janela janela;
+    unsigned NLArq, NCArq;
+
     /// Funcao set de alteracao de valor
+    /// Se a pagina da celula for compartilhada com outra copia do mapa, ela eh duplicada antes
     void set(unsigned i, unsigned j, EstadoCel valor);
     void set(const Coord& C, EstadoCel valor);
 
+    /// Fixa as dimensoes e o layout e aloca novas paginas para o vetor mapa
+    /// Todas as celulas (inclusive as de preenchimento) ficam como obstaculos
+    void dimensionar(unsigned numL, unsigned numC, LayoutMapa L);
+
+    /// Percorre o segmento A->B com o algoritmo de Bresenham, testando cada passo
+    /// com as mesmas regras de movimentoValido (inclusive a das quinas)
+    /// Se "celulas" nao for nullptr, acrescenta nele as celulas percorridas (exceto A)
+    /// Retorna true se todos os passos forem validos
+    bool percorreSegmento(const Coord& A, const Coord& B, vector<Coord>* celulas) const;
+    /// Copia para este mapa a janela J (jah ajustada as dimensoes) do mapa completo M
+    void copiaJanela(const Labirinto& M, const Janela& J, LayoutMapa L);
+    /// Marca como CAMINHO as celulas dos segmentos entre os pontos de "caminho"
+    void marcaCaminho();
+    /// Algoritmo Theta* (lazy=false) ou Lazy Theta* (lazy=true) entre Or e De
+    /// Preenche "pontos" com os vertices do caminho e retorna o seu comprimento (<0 se nao existe)
+    double buscaTheta(const Coord& Or, const Coord& De, bool lazy,
+                      vector<Coord>& pontos, int& NA, int& NF) const;
+    /// Algoritmo A* de varias origens para o mais proximo de varios alvos
+    /// (indices de celulas livres; os alvos em ordem crescente, sem repeticao)
+    /// "alvo" retorna o indice do alvo alcancado
+    /// Os demais parametros e o retorno sao os de buscaCaminho
+    double buscaAlvos(const vector<unsigned>& origens, const vector<unsigned>& alvos,
+                      vector<Coord>& pontos, unsigned& alvo, int& NA, int& NF,
+                      const Interrupcao* I, ContextoBusca* ctx) const;
+
 public:
     /// Cria um mapa vazio
     Labirinto();
@@ -72,12 +242,24 @@ public:
     /// Destrutor (nao eh obrigatorio...)
     ~Labirinto();
 
+    /// Dimensoes maximas aceitas por ler e gerar em todos os mapas
+    /// O padrao sao ALTURA_MAX_MAPA e LARGURA_MAX_MAPA (os mapas do programa interativo);
+    /// os modos de linha de comando e a leitura de mapas no programa interativo usam
+    /// ALTURA_MAX_BENCH e LARGURA_MAX_BENCH
+    /// Deve ser chamado antes de criar threads que leiam ou gerem mapas
+    static void setLimites(unsigned maxLin, unsigned maxCol);
+    static unsigned getAlturaMax();
+    static unsigned getLarguraMax();
+
     /// Torna o mapa vazio
     void clear();
 
     /// Limpa um eventual caminho anteriormente calculado
     void limpaCaminho();
 
+    /// Apaga a origem e o destino (e o caminho), sem alterar os obstaculos
+    void limpaOrigDest();
+
     /// Funcoes de consulta
     unsigned getNumLin() const;
     unsigned getNumCol() const;
@@ -90,6 +272,25 @@ public:
     /// Retorna o estado da celula C
     EstadoCel at(const Coord& C) const;
 
+    /// Funcoes de indexacao, de acordo com o layout do mapa
+    LayoutMapa getLayout() const;
+    /// Retorna o tamanho do vetor mapa (inclui as eventuais celulas de preenchimento)
+    unsigned getNumIndices() const;
+    /// Retorna o indice no vetor mapa da celula (i,j)
+    unsigned indice(unsigned i, unsigned j) const;
+    unsigned indice(const Coord& C) const;
+    /// Retorna as coordenadas da celula de indice idx (inverso de "indice")
+    Coord coordIndice(unsigned idx) const;
+    /// Retorna o indice da celula vizinha (deslocada de dl linhas e dc colunas,
+    /// com dl e dc entre -1 e 1) da celula de indice idx
+    /// Nao testa os limites: a celula vizinha deve estar dentro do mapa
+    unsigned indiceVizinho(unsigned idx, int dl, int dc) const;
+    /// Retorna o estado da celula de indice idx (sem teste de limites)
+    EstadoCel atIndice(unsigned idx) const;
+
+    /// Reorganiza as celulas do mapa de acordo com o novo layout
+    void setLayout(LayoutMapa L);
+
     /// Operador() de consulta - usa o metodo "at"
     /// Retorna o estado da celula correspondente ao i-j-esimo elemento do mapa
     EstadoCel operator()(unsigned i, unsigned j) const;
@@ -113,25 +314,81 @@ public:
     /// Fixa o destino do caminho a ser encontrado
     bool setDestino(const Coord& C);
 
+    /// Marca (obst=true) ou desmarca (obst=false) a celula C como obstaculo
+    /// Nao altera a origem nem o destino: retorna false se C for um deles ou for invalida
+    bool setObstaculo(const Coord& C, bool obst=true);
+
     /// Imprime o mapa no console
     void imprimir() const;
 
     /// Leh um mapa do arquivo nome_arq
     /// Caso nao consiga ler do arquivo, cria mapa vazio
+    /// O parametro L eh o layout das celulas na memoria
     /// Retorna true em caso de leitura bem sucedida
-    bool ler(const string& nome_arq);
+    bool ler(const string& nome_arq, LayoutMapa L=LayoutMapa::LINHAS);
+    /// Leh um mapa, no mesmo formato do arquivo, de uma stream qualquer
+    /// Caso a leitura falhe (cabecalho invalido ou celulas faltando), cria mapa vazio
+    bool ler(istream& I, LayoutMapa L=LayoutMapa::LINHAS);
     /// Salva um mapa no arquivo nome_arq
     /// Retorna true em caso de escrita bem sucedida
     bool salvar(const string& nome_arq) const;
+    /// Salva um mapa, no mesmo formato do arquivo, em uma stream qualquer
+    bool salvar(ostream& O) const;
+
+    /// Leh somente a janela J de um mapa salvo no arquivo nome_arq
+    /// A janela eh ajustada as dimensoes do mapa (e aumentada ate as dimensoes minimas)
+    /// O mapa lido tem as dimensoes da janela: a celula (i,j) dele eh a celula
+    /// (J.lin+i, J.col+j) do arquivo (ver getJanela, paraLocal e paraArquivo)
+    /// Os arquivos com linhas de tamanho fixo sao lidos com acesso direto as linhas
+    /// e colunas da janela: a codificacao compacta BITS e o formato texto de "salvar";
+    /// os demais (RLE ou texto editado a mao) sao lidos por inteiro e recortados
+    /// Retorna true em caso de leitura bem sucedida
+    bool ler(const string& nome_arq, const Janela& J, LayoutMapa L=LayoutMapa::LINHAS);
+    /// Retorna a janela do arquivo contida no mapa (o mapa inteiro, se nao foi lido com janela)
+    Janela getJanela() const;
+    /// Dimensoes do mapa completo no arquivo (as do mapa, se nao foi lido com janela)
+    unsigned getNumLinArq() const;
+    unsigned getNumColArq() const;
+    /// Conversao entre as coordenadas no arquivo e neste mapa
+    Coord paraLocal(const Coord& C) const;
+    Coord paraArquivo(const Coord& C) const;
+
+    /// Calcula o menor caminho entre as celulas Or e De (coordenadas no arquivo) lendo
+    /// somente uma janela do arquivo nome_arq em torno delas, com "margem" celulas a mais
+    /// Se o caminho encontrado na janela puder ser mais longo do que algum que saia dela
+    /// (ou se nao houver caminho na janela), a margem eh dobrada e a janela lida de novo
+    /// O resultado eh o mesmo da busca no mapa completo
+    /// O mapa fica com a ultima janela lida; "pontos" recebe as celulas do caminho em
+    /// coordenadas do arquivo e numLeituras (se nao for nullptr) o numero de janelas lidas
+    /// Retorna o comprimento do caminho (<0 se nao existe ou se o arquivo nao pode ser lido)
+    double buscaComJanela(const string& nome_arq, const Coord& Or, const Coord& De,
+                          vector<Coord>& pontos, unsigned margem=32, int* numLeituras=nullptr);
+
+    /// Retorna o tamanho em bytes da codificacao compacta do mapa no formato F
+    size_t tamanhoCompacto(FormatoCompacto F) const;
+    /// Escreve a codificacao compacta do mapa no formato F em buf (com tam bytes),
+    /// que pode ser, por exemplo, um segmento de memoria compartilhada
+    /// Retorna o numero de bytes escritos (0 em caso de erro)
+    size_t escreverCompacto(FormatoCompacto F, unsigned char* buf, size_t tam) const;
+    /// Leh um mapa da codificacao compacta em buf (com tam bytes)
+    /// Caso a codificacao seja invalida, cria mapa vazio
+    /// Retorna true em caso de leitura bem sucedida
+    bool lerCompacto(const unsigned char* buf, size_t tam, LayoutMapa L=LayoutMapa::LINHAS);
+    /// Salva / leh a codificacao compacta em um arquivo
+    bool salvarCompacto(const string& nome_arq, FormatoCompacto F) const;
+    bool lerCompacto(const string& nome_arq, LayoutMapa L=LayoutMapa::LINHAS);
 
     /// Gera um novo mapa aleatorio
     /// numL e numC sao as dimensoes do labirinto
     /// perc_obst eh o percentual de casas ocupadas no mapa. Se <=0, assume um valor aleatorio
     /// entre PERC_MIN_OBST e PERC_MAX_OBST
+    /// L eh o layout das celulas na memoria
+    /// semente eh a semente dos numeros aleatorios: a mesma semente (e os mesmos parametros)
+    /// gera o mesmo mapa. Se for 0, usa o relogio
     /// Se os parametros forem incorretos, gera um mapa vazio
     /// Retorna true em caso de geracao bem sucedida (parametros corretos)
     bool gerar(unsigned numL=ALTURA_MED_MAPA, unsigned numC=LARGURA_MED_MAPA,
-               double perc_obst=0.0);
+               double perc_obst=0.0, LayoutMapa L=LayoutMapa::LINHAS, unsigned semente=0);
 
     ///Calcula Heuristica
     double Heuristica(const Coord& ori, const Coord& de) const;
@@ -146,7 +403,85 @@ public:
     /// O parametro NA retorna o numero de nos em aberto ao termino do algoritmo A*
     /// O parametro NF retorna o numero de nos em fechado ao termino do algoritmo A*
     /// Mesmo quando nao existe caminho, esses parametros devem ser retornados
-    double calculaCaminho(int& NC, int& NA, int& NF);
+    ///
+    /// O parametro ctx eh o contexto cuja memoria a busca usa (ver buscaCaminho)
+    double calculaCaminho(int& NC, int& NA, int& NF, ContextoBusca* ctx=nullptr);
+
+    /// Calcula um caminho em qualquer angulo (any-angle) entre a origem e o destino
+    /// usando o algoritmo Theta* (lazy=false) ou Lazy Theta* (lazy=true)
+    /// Os segmentos do caminho sao retos entre vertices que tem linha de visada
+    /// Retorna o comprimento (euclidiano) do caminho (<0 se nao existe)
+    /// O parametro NC retorna o numero de segmentos do caminho (<0 se nao existe)
+    /// Os parametros NA e NF tem o mesmo significado que em calculaCaminho
+    double calculaCaminhoTheta(int& NC, int& NA, int& NF, bool lazy=false);
+
+    /// Calcula o caminho entre Or e De usando o algoritmo A*, sem alterar o mapa
+    /// (nao usa nem altera a origem, o destino e o caminho armazenados)
+    /// Pode ser chamado simultaneamente por varias threads, desde que o mapa nao seja alterado
+    /// Preenche "pontos" com as celulas do caminho, de Or a De
+    /// Retorna o comprimento do caminho (<0 se nao existe)
+    /// Retorna COMPR_INTERROMPIDA se a busca for interrompida por I
+    /// Os parametros NA e NF tem o mesmo significado que em calculaCaminho
+    /// Os nos da busca sao alocados no contexto ctx, que deve ser exclusivo da thread;
+    /// reusar o contexto evita alocacoes (nullptr = contexto novo, soh para esta consulta)
+    /// Retorna COMPR_SEM_MEMORIA se a busca ultrapassar o limite de memoria do contexto
+    double buscaCaminho(const Coord& Or, const Coord& De, vector<Coord>& pontos,
+                        int& NA, int& NF, const Interrupcao* I=nullptr,
+                        ContextoBusca* ctx=nullptr) const;
+
+    /// Calcula, com uma unica busca, o caminho de alguma das origens ao destino mais proximo
+    /// entre "destinos" (celulas invalidas ou obstaculos sao ignoradas), sem alterar o mapa
+    /// Preenche "pontos" com as celulas do caminho, da origem escolhida ao destino alcancado
+    /// "alvo" retorna a posicao em "destinos" do destino alcancado (-1 se nenhum)
+    /// Os demais parametros e o retorno sao os de buscaCaminho
+    double buscaMaisProximo(const vector<Coord>& origens, const vector<Coord>& destinos,
+                            vector<Coord>& pontos, int& alvo, int& NA, int& NF,
+                            const Interrupcao* I=nullptr, ContextoBusca* ctx=nullptr) const;
+
+    /// Calcula o caminho da origem ao destino mais proximo entre "destinos",
+    /// que passa a ser o destino do labirinto (exceto se for a propria origem: nesse caso,
+    /// o caminho tem um unico ponto e o destino nao eh alterado)
+    /// Os parametros e o retorno sao os de calculaCaminho
+    double calculaCaminhoMaisProximo(const vector<Coord>& destinos, int& NC, int& NA, int& NF,
+                                     ContextoBusca* ctx=nullptr);
+
+    /// Testa se existe linha de visada entre as celulas A e B, ou seja, se o segmento
+    /// A->B (percorrido pelo algoritmo de Bresenham) soh passa por celulas livres,
+    /// sem colidir com quinas nos passos em diagonal
+    bool linhaDeVisada(const Coord& A, const Coord& B) const;
+
+    /// Retorna os pontos do ultimo caminho calculado (vazio se nao ha caminho)
+    const vector<Coord>& getCaminho() const;
+
+    /// Suaviza o ultimo caminho calculado ("puxando o barbante"): elimina os pontos
+    /// intermediarios entre pontos que tem linha de visada entre si
+    /// Retorna o novo comprimento do caminho (<0 se nao ha caminho)
+    double suavizaCaminho();
+
+    /// Pre-processa o mapa (hierarquia de contracao), para acelerar as consultas seguintes
+    /// Soh vale enquanto os obstaculos nao mudarem (setObstaculo, ler, gerar descartam)
+    /// Retorna false se o mapa estiver vazio
+    bool preprocessar();
+    /// Testa se o mapa foi pre-processado
+    bool preprocessado() const;
+    /// Retorna o pre-processamento (nullptr se nao foi feito)
+    shared_ptr<const HierarquiaContracao> getPreprocessamento() const;
+    /// Salva o pre-processamento ao lado do arquivo do mapa nome_arq
+    /// (no arquivo nome_arq + EXTENSAO_PREPROCESSAMENTO)
+    bool salvarPreprocessamento(const string& nome_arq) const;
+    /// Leh o pre-processamento salvo ao lado do arquivo do mapa nome_arq
+    /// Retorna false se o arquivo nao existir ou nao corresponder ao mapa atual
+    bool lerPreprocessamento(const string& nome_arq);
+
+    /// Calcula o menor caminho entre Or e De usando o pre-processamento, sem alterar o mapa
+    /// O comprimento eh o mesmo de calculaCaminho (o caminho pode ser outro, de mesmo comprimento)
+    /// Pode ser chamado simultaneamente por varias threads, como buscaCaminho
+    /// Preenche "pontos" com as celulas do caminho e retorna o seu comprimento
+    /// (<0 se nao existe ou se o mapa nao foi pre-processado)
+    double buscaPreprocessada(const Coord& Or, const Coord& De, vector<Coord>& pontos) const;
+    /// Calcula o caminho entre a origem e o destino usando o pre-processamento
+    /// O parametro NC tem o mesmo significado que em calculaCaminho
+    double calculaCaminhoPreprocessado(int& NC);
 };
 
 #endif // _LABIRINTO_H_
@@ -1,19 +1,291 @@
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <chrono>
+#include <cstdlib>
 #include "labirinto.h"
+#include "benchmark.h"
+#include "servico.h"
+#include "serializacao.h"
+#include "onda.h"
+#include "contracao.h"
+#include "arena.h"
+#include "paralelo.h"
+#include "verificacao.h"
+#include "desenho.h"
+#include "reproducao.h"
 
 using namespace std;
 
-int main(void)
+/// Modos nao interativos, selecionados pela linha de comando:
+/// labirinto bench-layout [numL numC perc_obst]
+/// labirinto carga [numL numC numConsultas numThreads percCancel prazoMs]
+/// labirinto edicoes [numL numC numConsultas numThreads numLotes tamLote]
+/// labirinto compacto arquivo
+/// labirinto bench-onda [numL numC perc_obst numConsultas]
+/// labirinto preprocessar arquivo [numConsultas]
+/// labirinto bench-ch [numL numC perc_obst numConsultas]
+/// labirinto memoria [numL numC perc_obst numConsultas limiteKB]
+/// labirinto mais-proximo [numL numC perc_obst numAlvos numConsultas]
+/// labirinto hda [numL numC perc_obst numConsultas maxThreads]
+/// labirinto janela arquivo [numConsultas distMax margem]
+/// labirinto verificar [numMapas semente dimMax numConsultas]
+/// labirinto soak [segundos dim semente]
+/// labirinto bench-desenho [numL numC perc_obst]
+/// labirinto imagem arquivo saida.ppm|saida.pgm [escala]
+/// labirinto reproduzir log saida [numThreads capCache]   ("-" = entrada/saida padrao)
+/// labirinto gerar-log saida numConsultas mapa1 [mapa2 ...]
+/// Retorna o codigo de saida do programa
+int modoLinhaComando(int argc, char* argv[])
 {
+    // Mapas grandes sao permitidos somente nos modos de linha de comando
+    Labirinto::setLimites(ALTURA_MAX_BENCH, LARGURA_MAX_BENCH);
+    string modo = argv[1];
+    if (modo == "bench-layout")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 2000);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 2000);
+        double perc_obst = (argc > 4 ? atof(argv[4]) : 0.2);
+        benchLayouts(cout, numL, numC, perc_obst);
+        return 0;
+    }
+    if (modo == "carga")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 500);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 500);
+        unsigned numConsultas = (argc > 4 ? atoi(argv[4]) : 2000);
+        unsigned numThreads = (argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency());
+        double percCancel = (argc > 6 ? atof(argv[6]) : 0.1);
+        double prazoMs = (argc > 7 ? atof(argv[7]) : 0.0);
+        shared_ptr<Labirinto> M = make_shared<Labirinto>();
+        if (!M->gerar(numL, numC, 0.2))
+        {
+            cerr << "Erro na geracao do mapa\n";
+            return 1;
+        }
+        geradorCarga(cout, M, numConsultas, numThreads, 2, percCancel, prazoMs);
+        return 0;
+    }
+    if (modo == "edicoes")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 500);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 500);
+        unsigned numConsultas = (argc > 4 ? atoi(argv[4]) : 2000);
+        unsigned numThreads = (argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency());
+        unsigned numLotes = (argc > 6 ? atoi(argv[6]) : 100);
+        unsigned tamLote = (argc > 7 ? atoi(argv[7]) : 16);
+        Labirinto M;
+        if (!M.gerar(numL, numC, 0.2))
+        {
+            cerr << "Erro na geracao do mapa\n";
+            return 1;
+        }
+        cargaComEdicoes(cout, M, numConsultas, numThreads, numLotes, tamLote);
+        return 0;
+    }
+    if (modo == "bench-onda")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 200);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 200);
+        double perc_obst = (argc > 4 ? atof(argv[4]) : 0.05);
+        unsigned numConsultas = (argc > 5 ? atoi(argv[5]) : 10);
+        benchOnda(cout, numL, numC, perc_obst, numConsultas);
+        return 0;
+    }
+    if (modo == "preprocessar" && argc > 2)
+    {
+        unsigned numConsultas = (argc > 3 ? atoi(argv[3]) : 100);
+        Labirinto M;
+        if (!M.ler(argv[2]))
+        {
+            cerr << "Erro na leitura do arquivo " << argv[2] << endl;
+            return 1;
+        }
+        benchPreprocessamento(cout, M, argv[2], numConsultas);
+        return 0;
+    }
+    if (modo == "bench-ch")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 300);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 300);
+        double perc_obst = (argc > 4 ? atof(argv[4]) : 0.2);
+        unsigned numConsultas = (argc > 5 ? atoi(argv[5]) : 50);
+        Labirinto M;
+        if (!M.gerar(numL, numC, perc_obst))
+        {
+            cerr << "Erro na geracao do mapa\n";
+            return 1;
+        }
+        benchPreprocessamento(cout, M, "", numConsultas);
+        return 0;
+    }
+    if (modo == "memoria")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 1000);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 1000);
+        double perc_obst = (argc > 4 ? atof(argv[4]) : 0.2);
+        unsigned numConsultas = (argc > 5 ? atoi(argv[5]) : 100);
+        size_t limite = (argc > 6 ? size_t(atof(argv[6])*1024) : LIMITE_MEMORIA_BUSCA);
+        benchMemoria(cout, numL, numC, perc_obst, numConsultas, limite);
+        return 0;
+    }
+    if (modo == "mais-proximo")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 500);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 500);
+        double perc_obst = (argc > 4 ? atof(argv[4]) : 0.2);
+        unsigned numAlvos = (argc > 5 ? atoi(argv[5]) : 10);
+        unsigned numConsultas = (argc > 6 ? atoi(argv[6]) : 20);
+        benchMaisProximo(cout, numL, numC, perc_obst, numAlvos, numConsultas);
+        return 0;
+    }
+    if (modo == "hda")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 1000);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 1000);
+        double perc_obst = (argc > 4 ? atof(argv[4]) : 0.2);
+        unsigned numConsultas = (argc > 5 ? atoi(argv[5]) : 5);
+        unsigned maxThreads = (argc > 6 ? atoi(argv[6]) : 64);
+        benchHDA(cout, numL, numC, perc_obst, numConsultas, maxThreads);
+        return 0;
+    }
+    if (modo == "janela" && argc > 2)
+    {
+        unsigned numConsultas = (argc > 3 ? atoi(argv[3]) : 20);
+        unsigned distMax = (argc > 4 ? atoi(argv[4]) : 50);
+        unsigned margem = (argc > 5 ? atoi(argv[5]) : 32);
+        benchJanela(cout, argv[2], numConsultas, distMax, margem);
+        return 0;
+    }
+    if (modo == "verificar")
+    {
+        unsigned numMapas = (argc > 2 ? atoi(argv[2]) : 200);
+        unsigned semente = (argc > 3 ? atoi(argv[3]) : 1);
+        unsigned dimMax = (argc > 4 ? atoi(argv[4]) : 150);
+        unsigned numConsultas = (argc > 5 ? atoi(argv[5]) : 10);
+        return (verificaSolvers(cout, numMapas, semente, dimMax, numConsultas) ? 0 : 1);
+    }
+    if (modo == "soak")
+    {
+        double segundos = (argc > 2 ? atof(argv[2]) : 600.0);
+        unsigned dim = (argc > 3 ? atoi(argv[3]) : 1000);
+        unsigned semente = (argc > 4 ? atoi(argv[4]) : 1);
+        return (soakSolvers(cout, segundos, dim, semente) ? 0 : 1);
+    }
+    if (modo == "bench-desenho")
+    {
+        unsigned numL = (argc > 2 ? atoi(argv[2]) : 1000);
+        unsigned numC = (argc > 3 ? atoi(argv[3]) : 1000);
+        double perc_obst = (argc > 4 ? atof(argv[4]) : 0.2);
+        benchDesenho(cout, numL, numC, perc_obst);
+        return 0;
+    }
+    if (modo == "imagem" && argc > 3)
+    {
+        Labirinto M;
+        if (!M.ler(argv[2]))
+        {
+            cerr << "Erro na leitura do arquivo " << argv[2] << endl;
+            return 1;
+        }
+        string saida = argv[3];
+        FormatoImagem F = (saida.size() > 4 && saida.substr(saida.size()-4) == ".pgm"
+                           ? FormatoImagem::PGM : FormatoImagem::PPM);
+        unsigned escala = (argc > 4 ? atoi(argv[4]) : 1);
+        if (!exportaImagem(M, saida, F, escala))
+        {
+            cerr << "Erro na escrita do arquivo " << saida << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (modo == "reproduzir" && argc > 3)
+    {
+        string nomeLog = argv[2], nomeSaida = argv[3];
+        unsigned numThreads = (argc > 4 ? atoi(argv[4]) : thread::hardware_concurrency());
+        unsigned capCache = (argc > 5 ? atoi(argv[5]) : CAP_CACHE_MAPAS);
+        ifstream arqLog;
+        ofstream arqSaida;
+        if (nomeLog != "-")
+        {
+            arqLog.open(nomeLog.c_str());
+            if (!arqLog.is_open())
+            {
+                cerr << "Erro na leitura do arquivo " << nomeLog << endl;
+                return 1;
+            }
+        }
+        if (nomeSaida != "-")
+        {
+            arqSaida.open(nomeSaida.c_str());
+            if (!arqSaida.is_open())
+            {
+                cerr << "Erro na escrita do arquivo " << nomeSaida << endl;
+                return 1;
+            }
+        }
+        // Com os resultados na saida padrao, o relatorio vai para a saida de erros
+        bool ok = reproduzLog(nomeLog != "-" ? (istream&)arqLog : cin,
+                              nomeSaida != "-" ? (ostream&)arqSaida : cout,
+                              nomeSaida != "-" ? cout : cerr, numThreads, capCache);
+        return (ok ? 0 : 1);
+    }
+    if (modo == "gerar-log" && argc > 4)
+    {
+        ofstream arq(argv[2]);
+        vector<string> mapas(argv+4, argv+argc);
+        if (!arq.is_open() || !geraLog(arq, mapas, atol(argv[3])))
+        {
+            cerr << "Erro na geracao do log " << argv[2] << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (modo == "compacto" && argc > 2)
+    {
+        return (verificaCompacto(cout, argv[2]) ? 0 : 1);
+    }
+
+    cerr << "Modo desconhecido: " << modo << endl;
+    cerr << "Uso: " << argv[0] << " [bench-layout [numL numC perc_obst]]" << endl;
+    cerr << "     " << argv[0]
+         << " [carga [numL numC numConsultas numThreads percCancel prazoMs]]" << endl;
+    cerr << "     " << argv[0]
+         << " [edicoes [numL numC numConsultas numThreads numLotes tamLote]]" << endl;
+    cerr << "     " << argv[0] << " [compacto arquivo]" << endl;
+    cerr << "     " << argv[0] << " [bench-onda [numL numC perc_obst numConsultas]]" << endl;
+    cerr << "     " << argv[0] << " [preprocessar arquivo [numConsultas]]" << endl;
+    cerr << "     " << argv[0] << " [bench-ch [numL numC perc_obst numConsultas]]" << endl;
+    cerr << "     " << argv[0] << " [memoria [numL numC perc_obst numConsultas limiteKB]]" << endl;
+    cerr << "     " << argv[0] << " [mais-proximo [numL numC perc_obst numAlvos numConsultas]]" << endl;
+    cerr << "     " << argv[0] << " [hda [numL numC perc_obst numConsultas maxThreads]]" << endl;
+    cerr << "     " << argv[0] << " [janela arquivo [numConsultas distMax margem]]" << endl;
+    cerr << "     " << argv[0] << " [verificar [numMapas semente dimMax numConsultas]]" << endl;
+    cerr << "     " << argv[0] << " [soak [segundos dim semente]]" << endl;
+    cerr << "     " << argv[0] << " [bench-desenho [numL numC perc_obst]]" << endl;
+    cerr << "     " << argv[0] << " [imagem arquivo saida.ppm|saida.pgm [escala]]" << endl;
+    cerr << "     " << argv[0] << " [reproduzir log saida [numThreads capCache]]" << endl;
+    cerr << "     " << argv[0] << " [gerar-log saida numConsultas mapa1 [mapa2 ...]]" << endl;
+    return 1;
+}
+
+// Na compilacao para o libFuzzer (verificacao.h), o ponto de entrada eh o do fuzzer
+#ifndef LABIRINTO_FUZZER
+int main(int argc, char* argv[])
+{
+    // Sem parametros, executa o menu interativo
+    if (argc > 1) return modoLinhaComando(argc, argv);
+
     Labirinto L;
+    // Contexto (memoria) das buscas A*, reusado em todos os calculos
+    ContextoBusca ctx;
     int opcao;
 
     do
     {
         cout << endl;
-        L.imprimir();
+        // Mapas grandes (lidos de arquivo): visao geral e janela em torno do caminho
+        imprimeConsole(L);
         do
         {
             cout << endl
@@ -22,12 +294,17 @@ int main(void)
                  << "3 - Definir origem  "
                  << "4 - Definir destino  "
                  << "5 - Calcular caminho  "
+                 << endl
+                 << "6 - Caminho Theta*  "
+                 << "7 - Caminho Lazy Theta*  "
+                 << "8 - Suavizar caminho  "
+                 << "9 - Exportar imagem  "
                  << "0 - Sair"
                  << endl;
             cout << "OPCAO: ";
             cin >> opcao;
         }
-        while (opcao<0 || opcao>5);
+        while (opcao<0 || opcao>9);
 
         switch(opcao)
         {
@@ -46,7 +323,12 @@ int main(void)
                 cin >> arq;
             }
             while (arq == "");
-            if (!L.ler(arq))
+            // Mapas lidos podem ser grandes (impressos com visao geral e janela); os gerados
+            // continuam limitados as dimensoes do console
+            Labirinto::setLimites(ALTURA_MAX_BENCH, LARGURA_MAX_BENCH);
+            bool ok = L.ler(arq);
+            Labirinto::setLimites(ALTURA_MAX_MAPA, LARGURA_MAX_MAPA);
+            if (!ok)
             {
                 cerr << "Erro na leitura do arquivo " << arq << endl;
             }
@@ -85,6 +367,8 @@ int main(void)
             }
             break;
         case 5:
+        case 6:
+        case 7:
             if (L.empty() || !L.origDestDefinidos())
             {
                 cerr << "Mapa ou caminho indefinido..." << endl;
@@ -99,7 +383,8 @@ int main(void)
                     // Relogio antes da execucao
                     steady_clock::time_point t1 = steady_clock::now();
                     // Calcula o caminho
-                    comprCaminho = L.calculaCaminho(profCaminho, numA, numF);
+                    if (opcao == 5) comprCaminho = L.calculaCaminho(profCaminho, numA, numF, &ctx);
+                    else comprCaminho = L.calculaCaminhoTheta(profCaminho, numA, numF, opcao == 7);
                     // Relogio depois da execucao
                     steady_clock::time_point t2 = steady_clock::now();
                     // Diferenca entre os dois instantes de tempo
@@ -109,8 +394,13 @@ int main(void)
                 }
                 cout << "Tempo=" << deltaT << "ms\t"
                      << "\t Num nos ABERTO=" << numA
-                     << "\t Num nos FECHADO=" << numF
-                     << endl;
+                     << "\t Num nos FECHADO=" << numF;
+                if (opcao == 5) cout << "\t Memoria=" << ctx.getBytesConsulta()/1024 << "KB";
+                cout << endl;
+                if (comprCaminho == COMPR_SEM_MEMORIA)
+                {
+                    cerr << "Limite de memoria da busca ultrapassado..." << endl;
+                }
                 cout << (comprCaminho >= 0.0
                          ? "Caminho encontrado!"
                          : "Nao existe caminho!")
@@ -121,9 +411,46 @@ int main(void)
                 //cout << L.getOrig() << endl;
             }
             break;
+        case 8:
+            if (L.getCaminho().empty())
+            {
+                cerr << "Nenhum caminho calculado..." << endl;
+            }
+            else
+            {
+                double comprCaminho = L.suavizaCaminho();
+                cout << setprecision(4) << fixed
+                     << "Caminho suavizado!\t Comprimento=" << comprCaminho
+                     << "\t Segmentos=" << L.getCaminho().size()-1
+                     << endl;
+            }
+            break;
+        case 9:
+            if (L.empty())
+            {
+                cerr << "O mapa estah vazio..." << endl;
+            }
+            else
+            {
+                string arq;
+                do
+                {
+                    cout << "IMAGEM (.ppm ou .pgm, sem espacos): ";
+                    cin >> arq;
+                }
+                while (arq == "");
+                FormatoImagem F = (arq.size() > 4 && arq.substr(arq.size()-4) == ".pgm"
+                                   ? FormatoImagem::PGM : FormatoImagem::PPM);
+                if (!exportaImagem(L, arq, F))
+                {
+                    cerr << "Erro na escrita do arquivo " << arq << endl;
+                }
+            }
+            break;
         default:
             break;
         }
     }
     while (opcao != 0);
 }
+#endif // LABIRINTO_FUZZER
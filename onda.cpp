@@ -0,0 +1,936 @@
+#include <cmath>
+#include <climits>
+#include <iomanip>
+#include <cstdlib>
+#include <algorithm>
+
+#include "onda.h"
+
+/// Em x86 com GCC (ou Clang), a versao AVX2 do passo da busca em largura eh compilada sempre
+/// (atributo target) e escolhida em tempo de execucao, se o processador tiver AVX2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ONDA_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/// Cada linha eh armazenada com uma palavra nula de guarda antes e depois,
+/// para que os deslocamentos entre palavras vizinhas nao precisem de testes
+#define GUARDA 1
+/// Folga inicial (absoluta e relativa a distancia de Chebyshev) do limite da busca em largura
+#define FOLGA_MIN_ONDA 4.0
+#define FRACAO_FOLGA_ONDA 0.02
+/// Numero de custos reduzidos nao nulos dos movimentos (ver BuscaOnda::distancia)
+#define NUM_CUSTOS_ONDA 5
+/// Numero de baldes de aneis em ciclo (potencia de 2 maior que o maior salto de balde de
+/// um movimento, que eh 6)
+#define NUM_BALDES_ONDA 8
+
+/* ************************ */
+/* OPERACOES SOBRE LINHAS   */
+/* ************************ */
+
+/// Calcula a palavra w das celulas alcancadas em um passo, em uma linha alvo, a partir das
+/// linhas da frente de onda fC (linha de cima), fM (a propria linha) e fB (linha de baixo)
+/// lC, lM e lB sao as mascaras de livres dessas linhas e vis as celulas jah visitadas na alvo
+/// Um passo diagonal de (s,j) para (t,j+1) exige (s,j+1) e (t,j) livres (regra das quinas):
+/// por isso a frente da linha s eh mascarada pela linha t antes do deslocamento, e o
+/// resultado deslocado eh mascarado pela linha s
+/// Indice com sinal: as palavras w-1 e w+1 (guardas) sao acessadas
+static inline uint64_t passoPalavra(const uint64_t* fC, const uint64_t* fM, const uint64_t* fB,
+                                    const uint64_t* lC, const uint64_t* lM, const uint64_t* lB,
+                                    const uint64_t* vis, int w)
+{
+    uint64_t alvo = lM[w] & ~vis[w];
+
+    uint64_t o = (fM[w] << 1) | (fM[w-1] >> 63) | (fM[w] >> 1) | (fM[w+1] << 63) | fC[w] | fB[w];
+
+    uint64_t cM = fC[w] & lM[w], cA = fC[w-1] & lM[w-1], cP = fC[w+1] & lM[w+1];
+    uint64_t bM = fB[w] & lM[w], bA = fB[w-1] & lM[w-1], bP = fB[w+1] & lM[w+1];
+    uint64_t d = (((cM << 1) | (cA >> 63) | (cM >> 1) | (cP << 63)) & lC[w]) |
+                 (((bM << 1) | (bA >> 63) | (bM >> 1) | (bP << 63)) & lB[w]);
+
+    return (o | d) & alvo;
+}
+
+/// Calcula as palavras w0..w1 da linha alvo (ver passoPalavra) em "saida" e as acrescenta
+/// as visitadas
+/// Retorna o "ou" das palavras calculadas (nao nulo se alguma celula foi alcancada)
+static uint64_t passoLinhaEscalar(uint64_t* saida,
+                                  const uint64_t* fC, const uint64_t* fM, const uint64_t* fB,
+                                  const uint64_t* lC, const uint64_t* lM, const uint64_t* lB,
+                                  uint64_t* vis, int w0, int w1)
+{
+    uint64_t algum = 0;
+    for (int w=w0; w<=w1; w++)
+    {
+        uint64_t x = passoPalavra(fC, fM, fB, lC, lM, lB, vis, w);
+        saida[w] = x;
+        vis[w] |= x;
+        algum |= x;
+    }
+    return algum;
+}
+
+#ifdef ONDA_AVX2
+/// Mesmo que passoLinhaEscalar, com 4 palavras por vez
+__attribute__((target("avx2")))
+static uint64_t passoLinhaAVX2(uint64_t* saida,
+                               const uint64_t* fC, const uint64_t* fM, const uint64_t* fB,
+                               const uint64_t* lC, const uint64_t* lM, const uint64_t* lB,
+                               uint64_t* vis, int w0, int w1)
+{
+    int w = w0;
+    __m256i algum4 = _mm256_setzero_si256();
+    for (; w+3 <= w1; w += 4)
+    {
+#define CARREGA(p, d) _mm256_loadu_si256((const __m256i*)((p)+w+(d)))
+#define PARA_DIREITA(x, xAnt) _mm256_or_si256(_mm256_slli_epi64(x, 1), _mm256_srli_epi64(xAnt, 63))
+#define PARA_ESQUERDA(x, xProx) _mm256_or_si256(_mm256_srli_epi64(x, 1), _mm256_slli_epi64(xProx, 63))
+        __m256i v = CARREGA(vis,0);
+        __m256i alvo = _mm256_andnot_si256(v, CARREGA(lM,0));
+
+        __m256i o = _mm256_or_si256(PARA_DIREITA(CARREGA(fM,0), CARREGA(fM,-1)),
+                                    PARA_ESQUERDA(CARREGA(fM,0), CARREGA(fM,1)));
+        o = _mm256_or_si256(o, _mm256_or_si256(CARREGA(fC,0), CARREGA(fB,0)));
+
+        __m256i cM = _mm256_and_si256(CARREGA(fC,0), CARREGA(lM,0));
+        __m256i cA = _mm256_and_si256(CARREGA(fC,-1), CARREGA(lM,-1));
+        __m256i cP = _mm256_and_si256(CARREGA(fC,1), CARREGA(lM,1));
+        __m256i bM = _mm256_and_si256(CARREGA(fB,0), CARREGA(lM,0));
+        __m256i bA = _mm256_and_si256(CARREGA(fB,-1), CARREGA(lM,-1));
+        __m256i bP = _mm256_and_si256(CARREGA(fB,1), CARREGA(lM,1));
+        __m256i d = _mm256_and_si256(_mm256_or_si256(PARA_DIREITA(cM, cA), PARA_ESQUERDA(cM, cP)),
+                                     CARREGA(lC,0));
+        d = _mm256_or_si256(d, _mm256_and_si256(_mm256_or_si256(PARA_DIREITA(bM, bA),
+                                                PARA_ESQUERDA(bM, bP)), CARREGA(lB,0)));
+        d = _mm256_and_si256(_mm256_or_si256(o, d), alvo);
+
+        _mm256_storeu_si256((__m256i*)(saida+w), d);
+        _mm256_storeu_si256((__m256i*)(vis+w), _mm256_or_si256(v, d));
+        algum4 = _mm256_or_si256(algum4, d);
+#undef CARREGA
+#undef PARA_DIREITA
+#undef PARA_ESQUERDA
+    }
+    uint64_t algum = _mm256_testz_si256(algum4, algum4) ? 0 : 1;
+    // Restante das palavras
+    for (; w<=w1; w++)
+    {
+        uint64_t x = passoPalavra(fC, fM, fB, lC, lM, lB, vis, w);
+        saida[w] = x;
+        vis[w] |= x;
+        algum |= x;
+    }
+    return algum;
+}
+#endif
+
+typedef uint64_t (*FuncaoPasso)(uint64_t*, const uint64_t*, const uint64_t*, const uint64_t*,
+                                const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int);
+
+/// Testa (uma unica vez) se o processador tem AVX2
+static bool usaAVX2()
+{
+#ifdef ONDA_AVX2
+    static const bool tem = __builtin_cpu_supports("avx2");
+    return tem;
+#else
+    return false;
+#endif
+}
+
+/// Versao do passo da busca em largura usada neste processador
+static FuncaoPasso funcaoPasso()
+{
+#ifdef ONDA_AVX2
+    if (usaAVX2()) return passoLinhaAVX2;
+#endif
+    return passoLinhaEscalar;
+}
+
+/// Testa o bit da coluna j de uma linha
+static bool testaBit(const uint64_t* p, unsigned j)
+{
+    return (p[j/64] >> (j%64)) & 1;
+}
+
+/* ***************************** */
+/* MEMORIA DE TRABALHO DAS BUSCAS */
+/* ***************************** */
+
+/// Trecho de uma linha de um anel: as palavras w0..w1 da linha "lin", guardadas a partir
+/// da posicao "pos" das palavras do anel
+struct TrechoAnel
+{
+    int lin, w0, w1;
+    size_t pos;
+};
+
+/// Anel da distancia: celulas de mesmo valor exato A + B*sqrt(2) (ver BuscaOnda::distancia)
+/// Uma mesma linha pode aparecer em mais de um trecho; os trechos sao juntados quando o
+/// anel eh processado
+struct AnelOnda
+{
+    int A, B;
+    vector<TrechoAnel> trechos;
+    vector<uint64_t> palavras;
+
+    AnelOnda(): A(0), B(0), trechos(), palavras() {}
+
+    double valor() const { return A + B*sqrt(2.0); }
+};
+
+/// Memoria de trabalho das buscas, reusada entre as consultas de cada thread
+/// As mascaras ficam zeradas entre as consultas, exceto nas linhas [sujo0, sujo1] tocadas
+/// pela ultima consulta, que sao zeradas no inicio da seguinte
+struct MemoriaOnda
+{
+    /// Dimensoes das mascaras (NL linhas de S palavras)
+    unsigned NL, S;
+    /// Mascaras das celulas visitadas e das frentes de onda dos dois sentidos da busca
+    /// em largura (a distancia usa somente visitado[0]) e a nova frente em calculo
+    vector<uint64_t> visitado[2], frente[2], nova;
+    /// Primeira e ultima palavras nao nulas de cada linha das frentes (ini > fim se vazia)
+    vector<int> ini[2], fim[2], iniNova, fimNova;
+    int sujo0, sujo1;
+    /// Aneis da distancia; os de indice em "livres" estao vagos (com a memoria guardada)
+    vector<AnelOnda> aneis;
+    vector<int> livres;
+    /// Baldes dos aneis: o balde k (em ciclo, baldes[k % NUM_BALDES_ONDA]) tem os aneis de
+    /// valor em [k/2, (k+1)/2)
+    vector<int> baldes[NUM_BALDES_ONDA];
+    /// Linhas do anel em processamento (na mascara "nova")
+    vector<int> linhasAnel;
+    /// Celulas alcancadas a partir de uma linha do anel, separadas pelo custo reduzido do
+    /// movimento e pela linha alvo (acima, a propria, abaixo): NUM_CUSTOS_ONDA*3 linhas de
+    /// S palavras, zeradas entre os usos, com as faixas tocadas em iniAc e fimAc
+    vector<uint64_t> acumulado;
+    int iniAc[NUM_CUSTOS_ONDA*3], fimAc[NUM_CUSTOS_ONDA*3];
+    /// Celulas alvo de um movimento a partir de uma linha do anel
+    vector<uint64_t> alvos;
+
+    MemoriaOnda(): NL(0), S(0), sujo0(0), sujo1(-1)
+    {
+        fill(iniAc, iniAc + NUM_CUSTOS_ONDA*3, INT_MAX);
+        fill(fimAc, fimAc + NUM_CUSTOS_ONDA*3, -1);
+    }
+
+    /// Prepara uma consulta em mascaras de nl linhas de s palavras
+    void iniciar(unsigned nl, unsigned s)
+    {
+        if (nl != NL || s != S)
+        {
+            NL = nl;
+            S = s;
+            for (int k=0; k<2; k++)
+            {
+                visitado[k].assign(size_t(NL)*S, 0);
+                frente[k].assign(size_t(NL)*S, 0);
+                ini[k].assign(NL, INT_MAX);
+                fim[k].assign(NL, -1);
+            }
+            nova.assign(size_t(NL)*S, 0);
+            iniNova.assign(NL, INT_MAX);
+            fimNova.assign(NL, -1);
+            acumulado.assign(size_t(NUM_CUSTOS_ONDA*3)*S, 0);
+            alvos.assign(S, 0);
+        }
+        else if (sujo0 <= sujo1)
+        {
+            size_t de = size_t(sujo0)*S, ate = size_t(sujo1+1)*S;
+            for (int k=0; k<2; k++)
+            {
+                fill(visitado[k].begin()+de, visitado[k].begin()+ate, 0);
+                fill(frente[k].begin()+de, frente[k].begin()+ate, 0);
+                fill(ini[k].begin()+sujo0, ini[k].begin()+sujo1+1, INT_MAX);
+                fill(fim[k].begin()+sujo0, fim[k].begin()+sujo1+1, -1);
+            }
+            fill(nova.begin()+de, nova.begin()+ate, 0);
+            fill(iniNova.begin()+sujo0, iniNova.begin()+sujo1+1, INT_MAX);
+            fill(fimNova.begin()+sujo0, fimNova.begin()+sujo1+1, -1);
+        }
+        sujo0 = int(NL);
+        sujo1 = -1;
+        for (int k=0; k<NUM_BALDES_ONDA; k++) baldes[k].clear();
+        livres.clear();
+        for (size_t r=0; r<aneis.size(); r++)
+        {
+            aneis[r].trechos.clear();
+            aneis[r].palavras.clear();
+            livres.push_back(int(r));
+        }
+        linhasAnel.clear();
+    }
+
+    /// Registra que as linhas i0..i1 foram tocadas
+    void suja(int i0, int i1)
+    {
+        sujo0 = min(sujo0, max(i0, 0));
+        sujo1 = max(sujo1, min(i1, int(NL)-1));
+    }
+};
+
+/// Memoria de trabalho da thread
+static MemoriaOnda& memoriaOnda()
+{
+    static thread_local MemoriaOnda M;
+    return M;
+}
+
+/* ***************** */
+/* CLASSE BUSCAONDA  */
+/* ***************** */
+
+/// Monta a mascara de bits a partir do mapa L
+BuscaOnda::BuscaOnda(const Labirinto& L): NL(L.getNumLin()), NC(L.getNumCol()),
+    W((L.getNumCol()+63)/64), livre(), zeros()
+{
+    livre.assign(size_t(NL)*(W+2*GUARDA), 0);
+    zeros.assign(W+2*GUARDA, 0);
+    for (unsigned i=0; i<NL; i++)
+    {
+        uint64_t* p = &livre[size_t(i)*(W+2*GUARDA) + GUARDA];
+        for (unsigned j=0; j<NC; j++)
+        {
+            if (L.celulaLivre(Coord(i,j))) p[j/64] |= uint64_t(1) << (j%64);
+        }
+    }
+}
+
+/// Retorna a linha i da mascara de livres (ou a linha de zeros)
+const uint64_t* BuscaOnda::linhaLivre(int i) const
+{
+    if (i < 0 || i >= int(NL)) return &zeros[GUARDA];
+    return &livre[size_t(i)*(W+2*GUARDA) + GUARDA];
+}
+
+/// Busca em largura bidirecional com passos unitarios: a cada iteracao, a menor das duas
+/// frentes de onda (a partir de Or e a partir de De) avanca um movimento
+/// Os movimentos sao simetricos (inclusive a regra das quinas), logo a busca a partir de De
+/// encontra os caminhos de volta
+/// Em cada linha, somente as palavras vizinhas as nao nulas das frentes sao calculadas
+/// Quando a nova frente de um sentido toca as visitadas do outro pela primeira vez, o numero
+/// minimo de movimentos eh a soma das profundidades das duas frentes
+/// Uma celula a p movimentos de uma ponta so entra na frente se p mais a distancia de
+/// Chebyshev ate a outra ponta nao passar de "limite" (um quadrado em torno da outra ponta):
+/// as celulas dos caminhos de ate "limite" movimentos nunca sao descartadas, e um encontro
+/// com mais movimentos que isso nao eh garantidamente o minimo
+int BuscaOnda::passosLimitados(const Coord& Or, const Coord& De, int limite, bool& podou) const
+{
+    podou = false;
+    const size_t S = W+2*GUARDA;
+    const FuncaoPasso passoLinha = funcaoPasso();
+    MemoriaOnda& M = memoriaOnda();
+    M.iniciar(NL, S);
+
+    // Sentido 0: a partir de Or; sentido 1: a partir de De
+    // Linhas nao nulas das frentes, profundidades e numero de palavras calculadas
+    // no ultimo avanco (o tamanho das frentes)
+    int lin0[2], lin1[2], prof[2];
+    size_t tam[2];
+    const Coord C[2] = {Or, De};
+    for (int k=0; k<2; k++)
+    {
+        size_t pos = C[k].lin*S + GUARDA + C[k].col/64;
+        M.frente[k][pos] |= uint64_t(1) << (C[k].col%64);
+        M.visitado[k][pos] |= uint64_t(1) << (C[k].col%64);
+        M.ini[k][C[k].lin] = M.fim[k][C[k].lin] = C[k].col/64;
+        lin0[k] = lin1[k] = C[k].lin;
+        prof[k] = 0;
+        tam[k] = 1;
+        M.suja(C[k].lin, C[k].lin);
+    }
+
+    const int nl = NL, w = W;
+    while (true)
+    {
+        const int k = (tam[0] <= tam[1] ? 0 : 1);
+        uint64_t* frente = &M.frente[k][0];
+        uint64_t* visitado = &M.visitado[k][0];
+        const uint64_t* outro = &M.visitado[1-k][0];
+        int* ini = &M.ini[k][0];
+        int* fim = &M.fim[k][0];
+
+        // As linhas fora do mapa sao a linha de zeros
+        auto linhaFrente = [&](int i) -> const uint64_t*
+        {
+            if (i < 0 || i >= nl) return &zeros[GUARDA];
+            return frente + i*S + GUARDA;
+        };
+
+        // Quadrado (linhas t0..t1 e colunas c0..c1) das celulas dentro do limite
+        const Coord& A = C[1-k];
+        const int raio = limite - (prof[k]+1);
+        const int c0 = max(A.col - raio, 0), c1 = min(A.col + raio, int(NC)-1);
+        const int wc0 = c0/64, wc1 = c1/64;
+        const uint64_t m0 = ~uint64_t(0) << (c0%64), m1 = ~uint64_t(0) >> (63 - c1%64);
+        int t0 = max(lin0[k]-1, 0), t1 = min(lin1[k]+1, nl-1);
+        if (raio < 0 || t0 < A.lin - raio || t1 > A.lin + raio) podou = true;
+        t0 = max(t0, A.lin - raio);
+        t1 = min(t1, A.lin + raio);
+
+        int novo0 = -1, novo1 = -1;
+        size_t calculadas = 0;
+        bool encontro = false;
+        if (t0 <= t1) M.suja(t0, t1);
+        for (int t=t0; t<=t1; t++)
+        {
+            int w0 = INT_MAX, w1 = -1;
+            for (int i=max(t-1, lin0[k]); i<=min(t+1, lin1[k]); i++)
+            {
+                w0 = min(w0, ini[i]);
+                w1 = max(w1, fim[i]);
+            }
+            if (w0 > w1) continue;
+            w0 = max(w0-1, 0);
+            w1 = min(w1+1, w-1);
+            if (w0 < wc0 || w1 > wc1) podou = true;
+            w0 = max(w0, wc0);
+            w1 = min(w1, wc1);
+            if (w0 > w1) continue;
+
+            uint64_t* saida = &M.nova[t*S + GUARDA];
+            calculadas += w1-w0+1;
+            if (passoLinha(saida, linhaFrente(t-1), linhaFrente(t), linhaFrente(t+1),
+                           linhaLivre(t-1), linhaLivre(t), linhaLivre(t+1),
+                           visitado + t*S + GUARDA, w0, w1) == 0)
+            {
+                continue;
+            }
+
+            // Retira as colunas fora do limite nas palavras das pontas do quadrado
+            uint64_t* vis = visitado + t*S + GUARDA;
+            if (w0 == wc0 && (saida[w0] & ~m0) != 0)
+            {
+                vis[w0] &= ~(saida[w0] & ~m0);
+                saida[w0] &= m0;
+                podou = true;
+            }
+            if (w1 == wc1 && (saida[w1] & ~m1) != 0)
+            {
+                vis[w1] &= ~(saida[w1] & ~m1);
+                saida[w1] &= m1;
+                podou = true;
+            }
+
+            // Palavras nao nulas da nova linha e encontro com o outro sentido
+            while (w0 <= w1 && saida[w0] == 0) w0++;
+            if (w0 > w1) continue;
+            while (saida[w1] == 0) w1--;
+            M.iniNova[t] = w0;
+            M.fimNova[t] = w1;
+            const uint64_t* o = outro + t*S + GUARDA;
+            for (int p=w0; p<=w1; p++) encontro = encontro || (saida[p] & o[p]) != 0;
+            if (novo0 < 0) novo0 = t;
+            novo1 = t;
+        }
+        // Sem novas celulas, a componente de Or (ou de De) foi toda visitada sem encontro
+        if (novo0 < 0) return -1;
+        prof[k]++;
+        if (encontro)
+        {
+            if (prof[0] + prof[1] <= limite) return prof[0] + prof[1];
+            podou = true;
+            return -1;
+        }
+
+        // Zera a frente antiga (que passa a receber a proxima) e troca pela nova
+        for (int i=lin0[k]; i<=lin1[k]; i++)
+        {
+            if (ini[i] <= fim[i]) fill(frente + i*S + GUARDA + ini[i], frente + i*S + GUARDA + fim[i] + 1, 0);
+            ini[i] = INT_MAX;
+            fim[i] = -1;
+        }
+        M.frente[k].swap(M.nova);
+        M.ini[k].swap(M.iniNova);
+        M.fim[k].swap(M.fimNova);
+        lin0[k] = novo0;
+        lin1[k] = novo1;
+        tam[k] = calculadas;
+    }
+}
+
+/// Busca em largura com limites crescentes (ver distancia): a distancia de Chebyshev de Or
+/// a De (o menor numero de movimentos sem obstaculos) mais uma folga
+bool BuscaOnda::alcancavel(const Coord& Or, const Coord& De, int* numPassos) const
+{
+    if (numPassos != nullptr) *numPassos = -1;
+    if (!Or.valida() || !De.valida() || Or.lin >= int(NL) || De.lin >= int(NL) ||
+            Or.col >= int(NC) || De.col >= int(NC) ||
+            !testaBit(linhaLivre(Or.lin), Or.col) || !testaBit(linhaLivre(De.lin), De.col))
+    {
+        return false;
+    }
+    if (Or == De)
+    {
+        if (numPassos != nullptr) *numPassos = 0;
+        return true;
+    }
+
+    const int h = max(abs(Or.lin-De.lin), abs(Or.col-De.col));
+    for (double folga = max(FOLGA_MIN_ONDA, FRACAO_FOLGA_ONDA*h); ; folga *= 4)
+    {
+        bool podou;
+        int passos = passosLimitados(Or, De, int(min(h + folga, double(INT_MAX/2))), podou);
+        if (passos >= 0 || !podou)
+        {
+            if (numPassos != nullptr) *numPassos = passos;
+            return passos >= 0;
+        }
+    }
+}
+
+/// Custos reduzidos nao nulos dos movimentos, como (A,B): A + B*sqrt(2)
+static const int CUSTO_REDUZIDO[NUM_CUSTOS_ONDA][2] = {{2,-1}, {-2,2}, {0,1}, {2,0}, {0,2}};
+
+/// Distancia octil de (i,j) a De (o custo do menor caminho sem obstaculos), como A + B*sqrt(2)
+static inline void octilExata(int i, int j, const Coord& De, int& A, int& B)
+{
+    const int u = abs(j-De.col), v = abs(i-De.lin);
+    A = abs(u-v);
+    B = min(u, v);
+}
+
+/// Indice em CUSTO_REDUZIDO do custo reduzido do movimento (di,dj) a partir de (i,j): o custo
+/// do movimento mais a variacao da distancia octil ate De (-1 se for nulo)
+static int custoReduzido(int i, int j, int di, int dj, const Coord& De)
+{
+    int A0, B0, A1, B1;
+    octilExata(i, j, De, A0, B0);
+    octilExata(i+di, j+dj, De, A1, B1);
+    const bool diagonal = (di != 0 && dj != 0);
+    const int A = A1 - A0 + (diagonal ? 0 : 1), B = B1 - B0 + (diagonal ? 1 : 0);
+    for (int c=0; c<NUM_CUSTOS_ONDA; c++)
+    {
+        if (CUSTO_REDUZIDO[c][0] == A && CUSTO_REDUZIDO[c][1] == B) return c;
+    }
+    return -1;
+}
+
+/// Mascara das colunas c0..c1 na palavra w (nula se nao houver nenhuma)
+static inline uint64_t mascaraColunas(int w, int c0, int c1)
+{
+    const int lo = max(c0 - 64*w, 0), hi = min(c1 - 64*w, 63);
+    if (lo > hi) return 0;
+    return (~uint64_t(0) << lo) & (~uint64_t(0) >> (63-hi));
+}
+
+/// Espalha as celulas de g para a direita (colunas maiores) pelas celulas consecutivas de p
+/// (preenchimento de Kogge-Stone, em 6 passos)
+static inline uint64_t preencheDireita(uint64_t g, uint64_t p)
+{
+    g |= p & (g << 1);   p &= p << 1;
+    g |= p & (g << 2);   p &= p << 2;
+    g |= p & (g << 4);   p &= p << 4;
+    g |= p & (g << 8);   p &= p << 8;
+    g |= p & (g << 16);  p &= p << 16;
+    return g | (p & (g << 32));
+}
+
+/// Mesmo que preencheDireita, para a esquerda (colunas menores)
+static inline uint64_t preencheEsquerda(uint64_t g, uint64_t p)
+{
+    g |= p & (g >> 1);   p &= p >> 1;
+    g |= p & (g >> 2);   p &= p >> 2;
+    g |= p & (g >> 4);   p &= p >> 4;
+    g |= p & (g >> 8);   p &= p >> 8;
+    g |= p & (g >> 16);  p &= p >> 16;
+    return g | (p & (g >> 32));
+}
+
+/// A* por aneis: um anel tem as celulas de mesmo valor exato f = g + h, em que g eh o custo
+/// a partir de Or e h a distancia octil ate De, ambos inteiros A + B*sqrt(2)
+/// O custo reduzido de um movimento (o seu custo mais a variacao de h) so pode ser 0,
+/// 4-2*sqrt(2), 2*sqrt(2)-2, sqrt(2), 2 ou 2*sqrt(2) (CUSTO_REDUZIDO): os movimentos de custo
+/// reduzido nulo ficam no proprio anel, e os demais levam aos aneis de valor maior
+/// Os movimentos de custo reduzido nulo sempre se aproximam de De: na linha de distancia v
+/// da linha de De, os horizontais vao em direcao a coluna de De enquanto a distancia u a ela
+/// for maior que v; os verticais vao em direcao a linha de De nas colunas com u < v; os
+/// diagonais, em direcao a De nas duas coordenadas. Por isso o anel eh fechado em uma unica
+/// varredura das linhas, das mais distantes para a de De, cada uma preenchida (Kogge-Stone,
+/// com "vai um" entre as palavras) e passada a seguinte
+/// Em cada linha, o custo reduzido de cada movimento so muda nas colunas de u em
+/// {0, 1, v-1, v, v+1, v+2}: os alvos de cada movimento sao calculados por palavras e
+/// divididos por esses trechos de colunas
+/// Os aneis ficam em baldes de largura 1/2; como o menor custo reduzido nao nulo eh maior
+/// que 1/2, um balde nunca recebe aneis enquanto eh processado, e eh ordenado uma vez
+/// O primeiro valor que alcanca De eh a distancia (h eh consistente)
+double BuscaOnda::distancia(const Coord& Or, const Coord& De) const
+{
+    if (!Or.valida() || !De.valida() || Or.lin >= int(NL) || De.lin >= int(NL) ||
+            Or.col >= int(NC) || De.col >= int(NC) ||
+            !testaBit(linhaLivre(Or.lin), Or.col) || !testaBit(linhaLivre(De.lin), De.col))
+    {
+        return -1.0;
+    }
+    if (Or == De) return 0.0;
+
+    const size_t S = W+2*GUARDA;
+    MemoriaOnda& M = memoriaOnda();
+    M.iniciar(NL, S);
+    uint64_t* visitado = &M.visitado[0][0];
+    uint64_t* anel = &M.nova[0];
+    int* ini = &M.iniNova[0];
+    int* fim = &M.fimNova[0];
+    const int R0 = De.lin, C0 = De.col, nl = NL, nc = NC, w = W;
+    long vivos = 0;
+
+    // Indice do anel de valor (A,B), criado no seu balde se nao existir
+    auto achaAnel = [&](int A, int B) -> int
+    {
+        vector<int>& balde = M.baldes[long(floor(2*(A + B*sqrt(2.0)))) % NUM_BALDES_ONDA];
+        for (int r : balde)
+        {
+            if (M.aneis[r].A == A && M.aneis[r].B == B) return r;
+        }
+        int r;
+        if (M.livres.empty())
+        {
+            r = int(M.aneis.size());
+            M.aneis.push_back(AnelOnda());
+        }
+        else
+        {
+            r = M.livres.back();
+            M.livres.pop_back();
+        }
+        M.aneis[r].A = A;
+        M.aneis[r].B = B;
+        balde.push_back(r);
+        vivos++;
+        return r;
+    };
+
+    // Acrescenta ao anel r as palavras w0..w1 da linha lin (bits aponta para a palavra w0)
+    auto acrescentaTrecho = [&](int r, int lin, int w0, int w1, const uint64_t* bits)
+    {
+        AnelOnda& X = M.aneis[r];
+        TrechoAnel T = {lin, w0, w1, X.palavras.size()};
+        X.trechos.push_back(T);
+        X.palavras.insert(X.palavras.end(), bits, bits + (w1-w0+1));
+    };
+
+    // Fecha a linha s do anel: acrescenta as celulas alcancadas por movimentos horizontais de
+    // custo reduzido nulo, marca as visitadas e leva os verticais e diagonais de custo nulo
+    // para a linha seguinte em direcao a De
+    // Retorna true se De foi alcancado
+    auto fecha = [&](int s) -> bool
+    {
+        uint64_t* F = anel + s*S + GUARDA;
+        uint64_t* V = visitado + s*S + GUARDA;
+        const uint64_t* L = linhaLivre(s);
+        const int v = abs(s-R0);
+        int a = ini[s], b = fim[s];
+        for (int q=a; q<=b; q++) F[q] &= L[q] & ~V[q];
+
+        // A esquerda de De, para a direita ate a coluna C0-v; a direita, para a esquerda
+        // ate a coluna C0+v
+        const int cE = C0 - v, cD = C0 + v;
+        if (cE >= 0 && a <= cE/64)
+        {
+            uint64_t vai = 0;
+            for (int q=a; q<=cE/64; q++)
+            {
+                const uint64_t p = L[q] & ~V[q] & mascaraColunas(q, 0, cE);
+                F[q] = preencheDireita(F[q] | (vai & p), p);
+                vai = F[q] >> 63;
+            }
+            b = max(b, cE/64);
+        }
+        if (cD < nc && b >= cD/64)
+        {
+            uint64_t vai = 0;
+            for (int q=b; q>=cD/64; q--)
+            {
+                const uint64_t p = L[q] & ~V[q] & mascaraColunas(q, cD, nc-1);
+                F[q] = preencheEsquerda(F[q] | (vai & p), p);
+                vai = F[q] << 63;
+            }
+            a = min(a, cD/64);
+        }
+        while (a <= b && F[a] == 0) a++;
+        while (b >= a && F[b] == 0) b--;
+        if (a > b)
+        {
+            ini[s] = INT_MAX;
+            fim[s] = -1;
+            return false;
+        }
+        ini[s] = a;
+        fim[s] = b;
+        for (int q=a; q<=b; q++) V[q] |= F[q];
+        M.suja(s, s);
+        if (s == R0) return testaBit(F, C0);
+
+        // Verticais nas colunas com u < v; diagonais para a direita a partir das colunas a
+        // esquerda de De e para a esquerda a partir das colunas a direita (regra das quinas:
+        // a celula da linha t abaixo/acima da origem e a da linha s ao lado dela livres)
+        const int t = s + (s < R0 ? 1 : -1);
+        uint64_t* FT = anel + t*S + GUARDA;
+        const uint64_t* LT = linhaLivre(t);
+        const uint64_t* VT = visitado + t*S + GUARDA;
+        int a2 = INT_MAX, b2 = -1;
+        for (int q=max(a-1, 0); q<=min(b+1, w-1); q++)
+        {
+            const uint64_t dirAnt = F[q-1] & LT[q-1] & mascaraColunas(q-1, 0, C0-1);
+            const uint64_t dir = F[q] & LT[q] & mascaraColunas(q, 0, C0-1);
+            const uint64_t esq = F[q] & LT[q] & mascaraColunas(q, C0+1, nc-1);
+            const uint64_t esqProx = F[q+1] & LT[q+1] & mascaraColunas(q+1, C0+1, nc-1);
+            const uint64_t x = ((F[q] & mascaraColunas(q, C0-v+1, C0+v-1)) |
+                                (((dir << 1) | (dirAnt >> 63) | (esq >> 1) | (esqProx << 63)) & L[q])) &
+                               LT[q] & ~VT[q];
+            if (x == 0) continue;
+            FT[q] |= x;
+            a2 = min(a2, q);
+            b2 = q;
+        }
+        if (a2 <= b2)
+        {
+            if (ini[t] > fim[t]) M.linhasAnel.push_back(t);
+            ini[t] = min(ini[t], a2);
+            fim[t] = max(fim[t], b2);
+            M.suja(t, t);
+        }
+        return false;
+    };
+
+    int A0, B0;
+    octilExata(Or.lin, Or.col, De, A0, B0);
+    const uint64_t bitOr = uint64_t(1) << (Or.col%64);
+    acrescentaTrecho(achaAnel(A0, B0), Or.lin, Or.col/64, Or.col/64, &bitOr);
+
+    for (long k=long(floor(2*(A0 + B0*sqrt(2.0)))); vivos > 0; k++)
+    {
+        vector<int>& balde = M.baldes[k % NUM_BALDES_ONDA];
+        if (balde.empty()) continue;
+        sort(balde.begin(), balde.end(), [&](int x, int y) { return M.aneis[x].valor() < M.aneis[y].valor(); });
+
+        for (size_t ib=0; ib<balde.size(); ib++)
+        {
+            const int A = M.aneis[balde[ib]].A, B = M.aneis[balde[ib]].B;
+
+            // Junta os trechos do anel na mascara "anel" e libera o anel
+            {
+                AnelOnda& X = M.aneis[balde[ib]];
+                for (const TrechoAnel& T : X.trechos)
+                {
+                    uint64_t* p = anel + T.lin*S + GUARDA;
+                    if (ini[T.lin] > fim[T.lin]) M.linhasAnel.push_back(T.lin);
+                    for (int q=T.w0; q<=T.w1; q++) p[q] |= X.palavras[T.pos + (q-T.w0)];
+                    ini[T.lin] = min(ini[T.lin], T.w0);
+                    fim[T.lin] = max(fim[T.lin], T.w1);
+                    M.suja(T.lin, T.lin);
+                }
+                X.trechos.clear();
+                X.palavras.clear();
+                M.livres.push_back(balde[ib]);
+                vivos--;
+            }
+
+            // Fecha o anel: as linhas acima de De em ordem crescente, as abaixo em ordem
+            // decrescente (cada uma pode acrescentar a seguinte) e a linha de De por ultimo
+            vector<int>& linhas = M.linhasAnel;
+            sort(linhas.begin(), linhas.end());
+            const size_t n = linhas.size();
+            size_t p = 0;
+            for (int s=INT_MIN; ; )
+            {
+                while (p < n && linhas[p] <= s) p++;
+                int prox = (p < n ? linhas[p] : INT_MAX);
+                if (s != INT_MIN && s+1 < R0 && ini[s+1] <= fim[s+1]) prox = min(prox, s+1);
+                if (prox >= R0) break;
+                s = prox;
+                fecha(s);
+            }
+            p = n;
+            for (int s=INT_MAX; ; )
+            {
+                while (p > 0 && linhas[p-1] >= s) p--;
+                int prox = (p > 0 ? linhas[p-1] : INT_MIN);
+                if (s != INT_MAX && s-1 > R0 && ini[s-1] <= fim[s-1]) prox = max(prox, s-1);
+                if (prox <= R0) break;
+                s = prox;
+                fecha(s);
+            }
+            if (ini[R0] <= fim[R0] && fecha(R0)) return A + B*sqrt(2.0);
+
+            // Expande as linhas do anel para os aneis de valor maior
+            for (size_t il=0; il<linhas.size(); il++)
+            {
+                const int s = linhas[il];
+                if (ini[s] > fim[s]) continue;
+                const uint64_t* F = anel + s*S + GUARDA;
+                const uint64_t* L = linhaLivre(s);
+                const int v = abs(s-R0);
+
+                // Trechos de colunas das origens [c0[m], c1[m]], com u entre dois limites
+                // consecutivos, dos dois lados de De
+                int lim[6] = {0, 1, v-1, v, v+1, v+2};
+                sort(lim, lim+6);
+                const int nLim = int(unique(lim, lim+6) - lim);
+                int c0[12], c1[12], nTr = 0;
+                for (int m=0; m<nLim; m++)
+                {
+                    if (lim[m] < 0) continue;
+                    const int u0 = lim[m], u1 = (m+1 < nLim ? lim[m+1]-1 : nc);
+                    c0[nTr] = max(C0 + u0, 0);
+                    c1[nTr] = min(C0 + u1, nc-1);
+                    if (c0[nTr] <= c1[nTr]) nTr++;
+                    if (u0 == 0) continue;
+                    c0[nTr] = max(C0 - u1, 0);
+                    c1[nTr] = min(C0 - u0, nc-1);
+                    if (c0[nTr] <= c1[nTr]) nTr++;
+                }
+
+                const int q0 = max(ini[s]-1, 0), q1 = min(fim[s]+1, w-1);
+                uint64_t* alvos = &M.alvos[GUARDA];
+                for (int di=-1; di<=1; di++)
+                {
+                    const int t = s+di;
+                    if (t < 0 || t >= nl) continue;
+                    const uint64_t* LT = linhaLivre(t);
+                    const uint64_t* VT = visitado + t*S + GUARDA;
+                    for (int dj=-1; dj<=1; dj++)
+                    {
+                        if (di == 0 && dj == 0) continue;
+
+                        // Alvos do movimento (com a regra das quinas, se diagonal)
+                        int ta = INT_MAX, tb = -1;
+                        for (int q=q0; q<=q1; q++)
+                        {
+                            uint64_t x;
+                            if (dj == 0) x = F[q];
+                            else if (dj > 0) x = (((F[q] & LT[q]) << 1) | ((F[q-1] & LT[q-1]) >> 63)) & L[q];
+                            else x = (((F[q] & LT[q]) >> 1) | ((F[q+1] & LT[q+1]) << 63)) & L[q];
+                            x &= LT[q] & ~VT[q];
+                            alvos[q] = x;
+                            if (x == 0) continue;
+                            ta = min(ta, q);
+                            tb = q;
+                        }
+                        if (ta > tb) continue;
+
+                        // Divide os alvos pelos trechos de colunas das origens
+                        for (int m=0; m<nTr; m++)
+                        {
+                            const int c = custoReduzido(s, c0[m], di, dj, De);
+                            if (c < 0) continue;
+                            const int d0 = max(c0[m]+dj, 0), d1 = min(c1[m]+dj, nc-1);
+                            const int k3 = 3*c + di+1;
+                            uint64_t* ac = &M.acumulado[k3*S + GUARDA];
+                            for (int q=max(ta, d0/64); q<=min(tb, d1/64); q++)
+                            {
+                                const uint64_t y = alvos[q] & mascaraColunas(q, d0, d1);
+                                if (y == 0) continue;
+                                ac[q] |= y;
+                                M.iniAc[k3] = min(M.iniAc[k3], q);
+                                M.fimAc[k3] = max(M.fimAc[k3], q);
+                            }
+                        }
+                    }
+                }
+
+                // Leva as celulas alcancadas aos aneis e zera os acumulados
+                for (int k3=0; k3<NUM_CUSTOS_ONDA*3; k3++)
+                {
+                    if (M.iniAc[k3] > M.fimAc[k3]) continue;
+                    uint64_t* ac = &M.acumulado[k3*S + GUARDA];
+                    const int r = achaAnel(A + CUSTO_REDUZIDO[k3/3][0], B + CUSTO_REDUZIDO[k3/3][1]);
+                    acrescentaTrecho(r, s + k3%3 - 1, M.iniAc[k3], M.fimAc[k3], ac + M.iniAc[k3]);
+                    fill(ac + M.iniAc[k3], ac + M.fimAc[k3] + 1, 0);
+                    M.iniAc[k3] = INT_MAX;
+                    M.fimAc[k3] = -1;
+                }
+            }
+
+            // Zera a mascara do anel
+            for (int s : linhas)
+            {
+                if (ini[s] <= fim[s]) fill(anel + s*S + GUARDA + ini[s], anel + s*S + GUARDA + fim[s] + 1, 0);
+                ini[s] = INT_MAX;
+                fim[s] = -1;
+            }
+            linhas.clear();
+        }
+        balde.clear();
+    }
+    return -1.0;
+}
+
+/* ***************** */
+/* BENCHMARK         */
+/* ***************** */
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Compara BuscaOnda com calculaCaminho e buscaCaminho
+void benchOnda(ostream& O, unsigned numL, unsigned numC, double perc_obst, unsigned numConsultas)
+{
+    Labirinto L;
+    if (!L.gerar(numL, numC, perc_obst))
+    {
+        O << "Parametros invalidos para a geracao do mapa\n";
+        return;
+    }
+
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    BuscaOnda B(L);
+    double tMontagem = milissegundos(t1);
+
+    // Pares de celulas livres sorteadas (com semente fixa)
+    srand(1);
+    vector<Coord> origens, destinos;
+    while (origens.size() < numConsultas)
+    {
+        Coord Or(rand()%numL, rand()%numC), De(rand()%numL, rand()%numC);
+        if (L.celulaLivre(Or) && L.celulaLivre(De))
+        {
+            origens.push_back(Or);
+            destinos.push_back(De);
+        }
+    }
+
+    double tCalc = 0.0, tBusca = 0.0, tDist = 0.0, tAlc = 0.0;
+    unsigned diferencas = 0;
+    for (unsigned k=0; k<numConsultas; k++)
+    {
+        int NC, NA, NF, passos;
+        vector<Coord> pontos;
+
+        L.setOrigem(origens[k]);
+        L.setDestino(destinos[k]);
+        t1 = chrono::steady_clock::now();
+        double c1 = L.calculaCaminho(NC, NA, NF);
+        tCalc += milissegundos(t1);
+
+        t1 = chrono::steady_clock::now();
+        double c2 = L.buscaCaminho(origens[k], destinos[k], pontos, NA, NF);
+        tBusca += milissegundos(t1);
+
+        t1 = chrono::steady_clock::now();
+        double c3 = B.distancia(origens[k], destinos[k]);
+        tDist += milissegundos(t1);
+
+        t1 = chrono::steady_clock::now();
+        bool alc = B.alcancavel(origens[k], destinos[k], &passos);
+        tAlc += milissegundos(t1);
+
+        if (fabs(c1-c3) > 1e-6 || fabs(c2-c3) > 1e-6 || alc != (c1 >= 0.0)) diferencas++;
+    }
+
+    O << (usaAVX2() ? "ONDA (AVX2) " : "ONDA (escalar) ");
+    O << numL << 'x' << numC << " obst=" << perc_obst << ", " << numConsultas << " consultas" << endl;
+    O << fixed << setprecision(3)
+      << "Montagem da mascara=" << tMontagem << "ms" << endl
+      << "calculaCaminho=" << tCalc << "ms\t buscaCaminho=" << tBusca << "ms" << endl
+      << "Onda distancia=" << tDist << "ms\t Onda alcancavel=" << tAlc << "ms" << endl
+      << "Diferencas=" << diferencas << endl;
+}
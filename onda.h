@@ -0,0 +1,56 @@
+#ifndef _ONDA_H_
+#define _ONDA_H_
+
+#include <iostream>
+#include <cstdint>
+#include "labirinto.h"
+
+/// Busca em frente de onda sobre mascaras de bits
+/// Cada linha do mapa eh um vetor de palavras de 64 bits (1 bit por celula, 1=livre)
+/// e cada passo da busca processa muitas celulas da frente de onda de uma vez, com
+/// deslocamentos e operacoes logicas entre palavras (na busca em largura, 256 bits por vez
+/// com AVX2, se o processador tiver, ou 64 bits por vez)
+/// Os movimentos respeitam as regras de movimentoValido, inclusive a das quinas
+/// A mascara eh montada na construcao: alteracoes posteriores no mapa nao sao vistas
+class BuscaOnda
+{
+private:
+    /// Dimensoes do mapa e numero de palavras por linha
+    unsigned NL, NC, W;
+    /// Mascara das celulas livres (NL linhas de W palavras)
+    vector<uint64_t> livre;
+    /// Uma linha so com zeros (vizinha das linhas da borda)
+    vector<uint64_t> zeros;
+
+    /// Retorna a linha i da mascara de livres (ou a linha de zeros, se i estiver fora do mapa)
+    const uint64_t* linhaLivre(int i) const;
+
+    /// Busca em largura de Or a De que descarta as celulas cujo numero de movimentos mais a
+    /// distancia de Chebyshev ate a outra ponta passa de "limite"; retorna o numero minimo de
+    /// movimentos (<0 se nao foi encontrado dentro do limite) e, em "podou", se alguma celula
+    /// pode ter sido descartada
+    int passosLimitados(const Coord& Or, const Coord& De, int limite, bool& podou) const;
+
+public:
+    /// Monta a mascara de bits a partir do mapa L
+    explicit BuscaOnda(const Labirinto& L);
+
+    /// Testa se De eh alcancavel a partir de Or (busca em largura bidirecional, com passos
+    /// unitarios)
+    /// Se numPassos nao for nullptr, retorna nele o numero minimo de movimentos (<0 se inalcancavel)
+    bool alcancavel(const Coord& Or, const Coord& De, int* numPassos=nullptr) const;
+
+    /// Retorna o comprimento do menor caminho de Or a De (<0 se nao existe), com custo 1
+    /// para movimentos ortogonais e sqrt(2) para diagonais (o mesmo de calculaCaminho)
+    /// A* em que as celulas sao agrupadas em aneis de mesmo valor exato A + B*sqrt(2) (custo
+    /// ate a celula mais distancia octil ate De), processados em ordem crescente de valor
+    double distancia(const Coord& Or, const Coord& De) const;
+};
+
+/// Compara BuscaOnda com calculaCaminho e buscaCaminho em numConsultas consultas aleatorias
+/// em um mapa numL x numC com perc_obst de obstaculos
+/// Escreve em O os tempos e confere se os comprimentos sao iguais
+void benchOnda(std::ostream& O, unsigned numL, unsigned numC, double perc_obst,
+               unsigned numConsultas=10);
+
+#endif // _ONDA_H_
@@ -0,0 +1,303 @@
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "paralelo.h"
+
+using namespace std;
+
+/// Unidade da contagem de threads ativas no estado global
+#define ATIVA_HDA (uint64_t(1) << 32)
+/// Tolerancia na comparacao de custos (somas de passos em ordens diferentes)
+#define EPS_HDA 1e-9
+
+/// Entrada da lista de abertos de uma thread: (f, g, celula)
+struct EntradaHDA
+{
+    double f, g;
+    unsigned cel;
+
+    bool operator>(const EntradaHDA& E) const
+    {
+        return f > E.f;
+    }
+};
+
+typedef priority_queue<EntradaHDA, vector<EntradaHDA>, greater<EntradaHDA> > AbertosHDA;
+
+/* ***************** */
+/* CLASSE BUSCAHDA   */
+/* ***************** */
+
+BuscaHDA::BuscaHDA(const Labirinto& Lab, unsigned nThreads):
+    L(Lab), numThreads(max(nThreads, 1u)), g(), pai(),
+    caixas(new atomic<LoteHDA*>[max(nThreads, 1u)]), estado(0), fim(false),
+    incumbente(0.0), iOr(0), iDe(0), De(), numExpandidos(0), numMensagens(0)
+{
+    for (unsigned t=0; t<numThreads; t++) caixas[t].store(nullptr);
+}
+
+/// Thread dona da celula de indice idx (dispersao multiplicativa de Knuth)
+unsigned BuscaHDA::dona(unsigned idx) const
+{
+    return (uint64_t(idx*2654435761u) * numThreads) >> 32;
+}
+
+/// Calcula o caminho entre Or e De
+double BuscaHDA::buscar(const Coord& Or, const Coord& Dest, vector<Coord>& pontos)
+{
+    pontos.clear();
+    numExpandidos = numMensagens = 0;
+    if (!L.celulaLivre(Or) || !L.celulaLivre(Dest)) return -1.0;
+    if (Or == Dest)
+    {
+        pontos.push_back(Or);
+        return 0.0;
+    }
+
+    const unsigned N = L.getNumIndices();
+    g.assign(N, numeric_limits<double>::infinity());
+    pai.assign(N, N);
+    iOr = L.indice(Or);
+    iDe = L.indice(Dest);
+    De = Dest;
+
+    // A origem eh entregue a sua dona como uma mensagem (de custo 0, sem pai)
+    LoteHDA* inicial = new LoteHDA;
+    inicial->prox = nullptr;
+    inicial->msgs.push_back(MensagemHDA{iOr, iOr, 0.0});
+    caixas[dona(iOr)].store(inicial);
+
+    estado = numThreads*ATIVA_HDA + 1;
+    fim = false;
+    incumbente = numeric_limits<double>::infinity();
+
+    vector<thread> trabalhadores;
+    for (unsigned t=0; t<numThreads; t++) trabalhadores.push_back(thread(&BuscaHDA::trabalhar, this, t));
+    for (thread& T : trabalhadores) T.join();
+
+    if (incumbente.load() == numeric_limits<double>::infinity()) return -1.0;
+
+    // Monta o caminho do destino para a origem (todas as threads jah terminaram)
+    for (unsigned k=iDe; k!=iOr; k=pai[k]) pontos.push_back(L.coordIndice(k));
+    pontos.push_back(Or);
+    reverse(pontos.begin(), pontos.end());
+    return g[iDe];
+}
+
+/// Laco de cada thread
+/// Recebe as mensagens, expande os nos abertos enquanto f < incumbente e envia os
+/// sucessores as suas donas; sem trabalho, fica ociosa ate receber mensagens ou a busca terminar
+void BuscaHDA::trabalhar(unsigned id)
+{
+    AbertosHDA abertos;
+    vector<vector<MensagemHDA> > saida(numThreads);
+    bool ativa = true;
+    const bool sobrecarregado = (numThreads > thread::hardware_concurrency());
+    unsigned long expandidos = 0, enviadas = 0;
+
+    // Envia o lote de mensagens acumulado para a thread t
+    auto envia = [&](unsigned t)
+    {
+        if (saida[t].empty()) return;
+        LoteHDA* lote = new LoteHDA;
+        lote->msgs.swap(saida[t]);
+        // Conta as mensagens antes de torna-las visiveis
+        estado.fetch_add(lote->msgs.size());
+        enviadas += lote->msgs.size();
+        lote->prox = caixas[t].load();
+        while (!caixas[t].compare_exchange_weak(lote->prox, lote));
+    };
+
+    // Trata a chegada de uma celula por um caminho de custo gNovo
+    auto relaxa = [&](const MensagemHDA& M)
+    {
+        if (M.g >= g[M.cel] - EPS_HDA) return;
+        g[M.cel] = M.g;
+        pai[M.cel] = M.pai;
+        if (M.cel == iDe)
+        {
+            // Novo melhor caminho: o destino nao precisa ser expandido
+            double atual = incumbente.load();
+            while (M.g < atual && !incumbente.compare_exchange_weak(atual, M.g));
+            return;
+        }
+        double f = M.g + L.Heuristica(L.coordIndice(M.cel), De);
+        if (f < incumbente.load()) abertos.push(EntradaHDA{f, M.g, M.cel});
+    };
+
+    Coord dir;
+    while (!fim.load())
+    {
+        // Caixa de entrada
+        LoteHDA* lote = caixas[id].exchange(nullptr);
+        if (lote != nullptr)
+        {
+            if (!ativa)
+            {
+                // Fica ativa antes de dar baixa nas mensagens recebidas
+                estado.fetch_add(ATIVA_HDA);
+                ativa = true;
+            }
+            uint64_t recebidas = 0;
+            while (lote != nullptr)
+            {
+                for (const MensagemHDA& M : lote->msgs) relaxa(M);
+                recebidas += lote->msgs.size();
+                LoteHDA* prox = lote->prox;
+                delete lote;
+                lote = prox;
+            }
+            estado.fetch_sub(recebidas);
+        }
+
+        // Expansao de um bloco de nos
+        unsigned n = 0;
+        while (n < TAM_LOTE_HDA && !abertos.empty() && abertos.top().f < incumbente.load())
+        {
+            EntradaHDA E = abertos.top();
+            abertos.pop();
+            // Entrada desatualizada (a celula foi alcancada depois com custo menor)
+            if (E.g > g[E.cel] + EPS_HDA) continue;
+            n++;
+            expandidos++;
+
+            Coord pos = L.coordIndice(E.cel);
+            for (dir.lin = -1; dir.lin < 2; dir.lin++) for (dir.col = -1; dir.col < 2; dir.col++)
+                {
+                    Coord prox = pos + dir;
+                    if (dir == Coord(0,0) || !L.movimentoValido(pos, prox)) continue;
+                    unsigned iProx = L.indice(prox);
+                    MensagemHDA M = {iProx, E.cel, E.g + norm(dir)};
+                    unsigned t = dona(iProx);
+                    if (t == id) relaxa(M);
+                    else
+                    {
+                        saida[t].push_back(M);
+                        if (saida[t].size() >= TAM_LOTE_HDA) envia(t);
+                    }
+                }
+        }
+        if (n > 0)
+        {
+            // Ainda ha trabalho: os lotes incompletos sao enviados para nao deixar as outras ociosas
+            for (unsigned t=0; t<numThreads; t++) envia(t);
+            // Com mais threads que nucleos, cede a vez para que as outras acompanhem:
+            // sem isso, uma thread avanca muito na sua propria ordem e a sobrecarga explode
+            if (sobrecarregado) this_thread::yield();
+            continue;
+        }
+
+        // Sem trabalho: fica ociosa (os lotes pendentes jah foram enviados)
+        if (ativa)
+        {
+            for (unsigned t=0; t<numThreads; t++) envia(t);
+            ativa = false;
+            if (estado.fetch_sub(ATIVA_HDA) == ATIVA_HDA)
+            {
+                // Nenhuma thread ativa e nenhuma mensagem em transito
+                fim = true;
+            }
+        }
+        else this_thread::yield();
+    }
+
+    numExpandidos += expandidos;
+    numMensagens += enviadas;
+}
+
+/// Estatisticas da ultima busca
+unsigned long BuscaHDA::getNumExpandidos() const
+{
+    return numExpandidos;
+}
+
+unsigned long BuscaHDA::getNumMensagens() const
+{
+    return numMensagens;
+}
+
+/* ***************** */
+/* BENCHMARK         */
+/* ***************** */
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Compara a busca paralela com calculaCaminho
+void benchHDA(ostream& O, unsigned numL, unsigned numC, double perc_obst,
+              unsigned numConsultas, unsigned maxThreads)
+{
+    Labirinto L;
+    if (!L.gerar(numL, numC, perc_obst))
+    {
+        O << "Parametros invalidos para a geracao do mapa\n";
+        return;
+    }
+
+    // Consultas longas: cantos opostos do mapa (com semente fixa)
+    srand(1);
+    vector<Coord> origens, destinos;
+    while (origens.size() < numConsultas)
+    {
+        Coord Or(rand()%(numL/4), rand()%(numC/4));
+        Coord De(numL-1-rand()%(numL/4), numC-1-rand()%(numC/4));
+        if (L.celulaLivre(Or) && L.celulaLivre(De))
+        {
+            origens.push_back(Or);
+            destinos.push_back(De);
+        }
+    }
+
+    // Referencia serial
+    vector<double> compr(numConsultas);
+    unsigned long fechSerial = 0;
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    for (unsigned k=0; k<numConsultas; k++)
+    {
+        int NC, NA, NF;
+        L.setOrigem(origens[k]);
+        L.setDestino(destinos[k]);
+        compr[k] = L.calculaCaminho(NC, NA, NF);
+        fechSerial += max(NF, 0);
+    }
+    double tSerial = milissegundos(t1);
+    L.limpaOrigDest();
+
+    O << "HDA* " << numL << 'x' << numC << " obst=" << perc_obst << ", " << numConsultas
+      << " consultas, " << thread::hardware_concurrency() << " nucleos" << endl;
+    O << fixed << setprecision(3)
+      << "calculaCaminho: " << tSerial << "ms\t Expandidos=" << fechSerial << endl;
+    O << setw(8) << "threads" << setw(14) << "tempo(ms)" << setw(12) << "aceleracao"
+      << setw(12) << "sobrecarga" << setw(14) << "mensagens" << setw(12) << "diferencas" << endl;
+
+    for (unsigned numThreads=1; numThreads<=maxThreads; numThreads *= 2)
+    {
+        BuscaHDA B(L, numThreads);
+        unsigned long expandidos = 0, mensagens = 0;
+        unsigned diferencas = 0;
+        vector<Coord> pontos;
+        t1 = chrono::steady_clock::now();
+        for (unsigned k=0; k<numConsultas; k++)
+        {
+            double c = B.buscar(origens[k], destinos[k], pontos);
+            expandidos += B.getNumExpandidos();
+            mensagens += B.getNumMensagens();
+            if (fabs(c - compr[k]) > 1e-6) diferencas++;
+        }
+        double t = milissegundos(t1);
+        O << setw(8) << numThreads << setw(14) << t << setw(12) << tSerial/max(t, 1e-9)
+          << setw(11) << 100.0*(double(expandidos)/max(fechSerial, 1ul) - 1.0) << '%'
+          << setw(14) << mensagens << setw(12) << diferencas << endl;
+    }
+}
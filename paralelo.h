@@ -0,0 +1,86 @@
+#ifndef _PARALELO_H_
+#define _PARALELO_H_
+
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include "labirinto.h"
+
+/// Numero maximo de mensagens em um lote enviado de uma thread para outra
+#define TAM_LOTE_HDA 64
+
+/// Uma mensagem entre threads: a celula cel foi alcancada com custo g a partir de pai
+struct MensagemHDA
+{
+    unsigned cel;
+    unsigned pai;
+    double g;
+};
+
+/// Lote de mensagens, encadeado na caixa de entrada da thread de destino
+struct LoteHDA
+{
+    LoteHDA* prox;
+    vector<MensagemHDA> msgs;
+};
+
+/// Busca A* paralela de uma unica consulta (HDA*, Hash Distributed A*)
+/// Cada celula pertence a uma thread, escolhida por uma funcao de dispersao do indice
+/// da celula; soh a dona expande a celula e guarda o seu custo g e o seu pai
+/// Os sucessores gerados sao enviados as suas donas em lotes, por caixas de entrada
+/// sem travas (pilhas atomicas: varios produtores, um consumidor)
+/// A busca termina quando nao ha mensagens em transito e nenhuma thread tem nos abertos
+/// com custo f menor que o do melhor caminho encontrado; como a heuristica eh consistente,
+/// esse caminho eh otimo (mesmo comprimento de calculaCaminho)
+/// Os nos podem ser expandidos mais de uma vez (reabertos), pois cada thread segue a sua
+/// propria ordem: essa eh a sobrecarga de busca em relacao ao A* serial
+class BuscaHDA
+{
+private:
+    const Labirinto& L;
+    unsigned numThreads;
+
+    /// Custo g e pai de cada celula (cada posicao eh escrita soh pela thread dona)
+    vector<double> g;
+    vector<unsigned> pai;
+    /// Caixas de entrada de cada thread
+    unique_ptr<atomic<LoteHDA*>[]> caixas;
+    /// Estado global: numero de threads ativas (32 bits altos) e de mensagens
+    /// enviadas e ainda nao processadas (32 bits baixos)
+    /// Chega a zero exatamente quando a busca termina
+    atomic<uint64_t> estado;
+    atomic<bool> fim;
+    /// Custo do melhor caminho encontrado ate o momento
+    atomic<double> incumbente;
+    /// Indice da origem e do destino da consulta atual
+    unsigned iOr, iDe;
+    Coord De;
+    /// Contadores de nos expandidos e de mensagens enviadas entre threads
+    atomic<unsigned long> numExpandidos, numMensagens;
+
+    /// Thread dona da celula de indice idx
+    unsigned dona(unsigned idx) const;
+    /// Laco de cada thread
+    void trabalhar(unsigned id);
+
+public:
+    /// Prepara a busca sobre o mapa L (que nao pode ser alterado durante as buscas)
+    BuscaHDA(const Labirinto& L, unsigned numThreads);
+
+    /// Calcula o caminho entre Or e De
+    /// Preenche "pontos" com as celulas do caminho e retorna o seu comprimento (<0 se nao existe)
+    double buscar(const Coord& Or, const Coord& De, vector<Coord>& pontos);
+
+    /// Estatisticas da ultima busca
+    unsigned long getNumExpandidos() const;
+    unsigned long getNumMensagens() const;
+};
+
+/// Compara a busca paralela (1, 2, 4, ... ate maxThreads threads) com calculaCaminho em
+/// numConsultas consultas aleatorias em um mapa numL x numC com perc_obst de obstaculos
+/// Escreve em O, para cada numero de threads, o tempo, a aceleracao, a sobrecarga de busca
+/// (nos expandidos alem dos do A* serial) e o numero de comprimentos divergentes
+void benchHDA(std::ostream& O, unsigned numL, unsigned numC, double perc_obst,
+              unsigned numConsultas=5, unsigned maxThreads=64);
+
+#endif // _PARALELO_H_
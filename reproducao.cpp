@@ -0,0 +1,348 @@
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+#include "reproducao.h"
+#include "servico.h"
+#include "fila.h"
+#include "arena.h"
+
+using namespace std;
+
+/// Numero maximo de lotes em processamento (lidos e ainda nao escritos), por thread
+#define LOTES_POR_THREAD 4
+
+/* ***************** */
+/* CLASSE CACHEMAPAS */
+/* ***************** */
+
+CacheMapas::CacheMapas(unsigned cap, LayoutMapa L): capacidade(max(cap, 1u)), layout(L),
+    uso(), indice(), acertos(0), faltas(0), preprocessados(0) {}
+
+/// Retorna o mapa do arquivo nome_arq, lendo-o se nao estiver na cache
+shared_ptr<const Labirinto> CacheMapas::obter(const string& nome_arq)
+{
+    // Caso mais comum em um log: o mesmo mapa do registro anterior
+    if (!uso.empty() && uso.front().first == nome_arq)
+    {
+        acertos++;
+        return uso.front().second;
+    }
+
+    auto it = indice.find(nome_arq);
+    if (it != indice.end())
+    {
+        // Passa a ser o usado mais recentemente
+        uso.splice(uso.begin(), uso, it->second);
+        acertos++;
+        return uso.front().second;
+    }
+
+    faltas++;
+    shared_ptr<Labirinto> M = make_shared<Labirinto>();
+    if (!M->lerCompacto(nome_arq, layout) && !M->ler(nome_arq, layout)) M.reset();
+    // Pre-processamento salvo ao lado do mapa, se houver
+    else if (M->lerPreprocessamento(nome_arq)) preprocessados++;
+
+    if (uso.size() >= capacidade)
+    {
+        indice.erase(uso.back().first);
+        uso.pop_back();
+    }
+    uso.push_front(Entrada(nome_arq, M));
+    indice[nome_arq] = uso.begin();
+    return M;
+}
+
+/// Estatisticas de uso
+unsigned long CacheMapas::getAcertos() const
+{
+    return acertos;
+}
+
+unsigned long CacheMapas::getFaltas() const
+{
+    return faltas;
+}
+
+unsigned long CacheMapas::getPreprocessados() const
+{
+    return preprocessados;
+}
+
+/* ***************** */
+/* REPRODUCAO        */
+/* ***************** */
+
+/// Um registro do log, com o seu resultado
+struct ItemReproducao
+{
+    shared_ptr<const Labirinto> mapa;
+    Coord orig, dest;
+    EstadoResposta estado;
+    double compr;
+    /// Duracao da busca, em milissegundos
+    float buscaMs;
+    /// Instante em que o registro foi lido do log
+    chrono::steady_clock::time_point leitura;
+};
+
+/// Um lote de registros consecutivos do log
+struct LoteReproducao
+{
+    /// Numero do lote e posicao do seu primeiro registro no log
+    unsigned long num, primeiro;
+    vector<ItemReproducao> itens;
+};
+
+typedef FilaLimitada<unique_ptr<LoteReproducao> > FilaLotes;
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Leh um inteiro nao negativo a partir de p, pulando os espacos antes dele
+/// Retorna false se nao houver um numero
+static bool leNumero(const char*& p, int& n)
+{
+    while (*p == ' ' || *p == '\t') p++;
+    if (!isdigit((unsigned char)*p)) return false;
+    long v = 0;
+    while (isdigit((unsigned char)*p) && v <= ALTURA_MAX_BENCH + LARGURA_MAX_BENCH) v = 10*v + (*p++ - '0');
+    n = int(v);
+    return !isdigit((unsigned char)*p);
+}
+
+/// Separa um registro "mapa linOr colOr linDe colDe" em seus campos
+static bool leRegistro(const string& linha, string& mapa, Coord& Or, Coord& De)
+{
+    const char* p = linha.c_str();
+    while (*p == ' ' || *p == '\t') p++;
+    const char* ini = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+    if (p == ini) return false;
+    mapa.assign(ini, p);
+    if (!leNumero(p, Or.lin) || !leNumero(p, Or.col) || !leNumero(p, De.lin) || !leNumero(p, De.col))
+    {
+        return false;
+    }
+    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+    return *p == '\0';
+}
+
+/// Percentil q (entre 0 e 1) de valores jah ordenados
+static double percentil(const vector<float>& V, double q)
+{
+    if (V.empty()) return 0.0;
+    return V[min(V.size()-1, size_t(q*V.size()))];
+}
+
+/// Escreve em O os percentis de V (que eh ordenado)
+static void escrevePercentis(ostream& O, const string& nome, vector<float>& V)
+{
+    sort(V.begin(), V.end());
+    O << "Latencia " << nome << "(ms): p50=" << percentil(V, 0.5) << " p90=" << percentil(V, 0.9)
+      << " p99=" << percentil(V, 0.99) << " p99.9=" << percentil(V, 0.999)
+      << " max=" << (V.empty() ? 0.0 : V.back()) << endl;
+}
+
+/// Reproduz um log de consultas
+bool reproduzLog(istream& log, ostream& saida, ostream& relatorio, unsigned numThreads,
+                 unsigned capCache)
+{
+    numThreads = max(numThreads, 1u);
+    const unsigned maxLotes = LOTES_POR_THREAD*numThreads + 2;
+    FilaLotes lidos(maxLotes), resolvidos(maxLotes);
+    // Fichas que limitam os lotes em processamento: sem elas, um lote demorado faria os
+    // seguintes se acumularem na escrita, a espera da sua vez
+    FilaLimitada<int> fichas(maxLotes);
+    for (unsigned k=0; k<maxLotes; k++) fichas.inserir(0);
+
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+
+    // Estagio 2: resolucao das consultas
+    vector<thread> trabalhadores;
+    for (unsigned t=0; t<numThreads; t++)
+    {
+        trabalhadores.push_back(thread([&]
+        {
+            ContextoBusca ctx;
+            vector<Coord> pontos;
+            unique_ptr<LoteReproducao> lote;
+            while (lidos.retirar(lote))
+            {
+                for (ItemReproducao& R : lote->itens)
+                {
+                    if (R.estado == EstadoResposta::REJEITADA) continue;
+                    int NA, NF;
+                    chrono::steady_clock::time_point tBusca = chrono::steady_clock::now();
+                    if (R.mapa->preprocessado()) R.compr = R.mapa->buscaPreprocessada(R.orig, R.dest, pontos);
+                    else R.compr = R.mapa->buscaCaminho(R.orig, R.dest, pontos, NA, NF, nullptr, &ctx);
+                    R.buscaMs = milissegundos(tBusca);
+                    if (R.compr == COMPR_SEM_MEMORIA) R.estado = EstadoResposta::SEM_MEMORIA;
+                    else R.estado = (R.compr >= 0.0 ? EstadoResposta::ENCONTRADO : EstadoResposta::SEM_CAMINHO);
+                    // O mapa pode ser liberado antes da escrita
+                    R.mapa.reset();
+                }
+                resolvidos.inserir(move(lote));
+            }
+        }));
+    }
+
+    // Estagio 3: escrita dos resultados, na ordem dos lotes
+    unsigned long totais[NUM_ESTADOS_RESPOSTA] = {0};
+    vector<float> latBusca, latTotal;
+    bool saidaOk = true;
+    thread escritor([&]
+    {
+        string nomes[NUM_ESTADOS_RESPOSTA];
+        for (int e=0; e<NUM_ESTADOS_RESPOSTA; e++) nomes[e] = estadoResposta2string(EstadoResposta(e));
+        map<unsigned long, unique_ptr<LoteReproducao> > fora;
+        unsigned long proximo = 0;
+        string buf;
+        char linha[128];
+        unique_ptr<LoteReproducao> lote;
+        while (resolvidos.retirar(lote))
+        {
+            unsigned long num = lote->num;
+            fora[num] = move(lote);
+            if (num != proximo) continue;
+            // Escreve todos os lotes jah disponiveis na sequencia
+            while (!fora.empty() && fora.begin()->first == proximo)
+            {
+                unique_ptr<LoteReproducao> L = move(fora.begin()->second);
+                fora.erase(fora.begin());
+                buf.clear();
+                for (unsigned k=0; k<L->itens.size(); k++)
+                {
+                    const ItemReproducao& R = L->itens[k];
+                    int tam = snprintf(linha, sizeof(linha), "%lu %s %.4f\n", L->primeiro+k,
+                                       nomes[int(R.estado)].c_str(), R.compr);
+                    buf.append(linha, tam);
+                    totais[int(R.estado)]++;
+                    if (R.estado != EstadoResposta::REJEITADA) latBusca.push_back(R.buscaMs);
+                }
+                saida.write(buf.data(), buf.size());
+                if (!saida) saidaOk = false;
+                // Latencia de cada registro: da sua leitura ate a escrita do lote
+                for (const ItemReproducao& R : L->itens) latTotal.push_back(milissegundos(R.leitura));
+                proximo++;
+                fichas.inserir(0);
+            }
+        }
+        saida.flush();
+    });
+
+    // Estagio 1 (nesta thread): leitura do log
+    CacheMapas cache(capCache);
+    unsigned long numRegistros = 0, numLotes = 0;
+    string linha, nomeMapa;
+    unique_ptr<LoteReproducao> lote;
+    int ficha;
+    while (getline(log, linha))
+    {
+        size_t ini = linha.find_first_not_of(" \t\r");
+        if (ini == string::npos || linha[ini] == '#') continue;
+
+        if (!lote)
+        {
+            fichas.retirar(ficha);
+            lote.reset(new LoteReproducao);
+            lote->num = numLotes++;
+            lote->primeiro = numRegistros;
+            lote->itens.reserve(TAM_LOTE_REPRODUCAO);
+        }
+        ItemReproducao R;
+        R.estado = EstadoResposta::REJEITADA;
+        R.compr = -1.0;
+        R.buscaMs = 0.0;
+        R.leitura = chrono::steady_clock::now();
+        if (leRegistro(linha, nomeMapa, R.orig, R.dest))
+        {
+            R.mapa = cache.obter(nomeMapa);
+            if (R.mapa && R.mapa->coordValida(R.orig) && R.mapa->coordValida(R.dest))
+            {
+                R.estado = EstadoResposta::ENCONTRADO;
+            }
+            else R.mapa.reset();
+        }
+        lote->itens.push_back(move(R));
+        numRegistros++;
+
+        if (lote->itens.size() == TAM_LOTE_REPRODUCAO) lidos.inserir(move(lote));
+    }
+    if (lote) lidos.inserir(move(lote));
+
+    lidos.fechar();
+    for (thread& T : trabalhadores) T.join();
+    resolvidos.fechar();
+    escritor.join();
+    double tTotal = milissegundos(t1);
+
+    relatorio << "REPRODUCAO " << numRegistros << " registros, " << numThreads << " threads" << endl;
+    relatorio << fixed << setprecision(3)
+              << "Tempo=" << tTotal << "ms\t Vazao=" << 1000.0*numRegistros/max(tTotal, 1e-9)
+              << " consultas/s (" << 60000.0*numRegistros/max(tTotal, 1e-9) << " por minuto)" << endl;
+    for (int e=0; e<NUM_ESTADOS_RESPOSTA; e++)
+    {
+        relatorio << estadoResposta2string(EstadoResposta(e)) << '=' << totais[e] << ' ';
+    }
+    relatorio << endl;
+    relatorio << "Cache de mapas: acertos=" << cache.getAcertos() << " faltas=" << cache.getFaltas()
+              << " pre-processados=" << cache.getPreprocessados() << endl;
+    escrevePercentis(relatorio, "da busca", latBusca);
+    escrevePercentis(relatorio, "total", latTotal);
+    if (!saidaOk) relatorio << "Erro na escrita dos resultados" << endl;
+    return saidaOk;
+}
+
+/// Gera um log de consultas aleatorias
+bool geraLog(ostream& O, const vector<string>& mapas, unsigned long numConsultas, unsigned semente)
+{
+    // Celulas livres de cada mapa
+    CacheMapas cache(mapas.size());
+    vector<vector<Coord> > livres(mapas.size());
+    for (unsigned m=0; m<mapas.size(); m++)
+    {
+        shared_ptr<const Labirinto> M = cache.obter(mapas[m]);
+        if (!M) return false;
+        for (unsigned i=0; i<M->getNumLin(); i++) for (unsigned j=0; j<M->getNumCol(); j++)
+            {
+                if (M->celulaLivre(Coord(i,j))) livres[m].push_back(Coord(i,j));
+            }
+        if (livres[m].empty()) return false;
+    }
+    if (mapas.empty()) return false;
+
+    mt19937 gerador(semente);
+    uniform_int_distribution<unsigned> sorteioMapa(0, mapas.size()-1);
+    string buf;
+    char linha[64];
+    for (unsigned long k=0; k<numConsultas; k++)
+    {
+        unsigned m = sorteioMapa(gerador);
+        uniform_int_distribution<unsigned> sorteioCel(0, livres[m].size()-1);
+        const Coord& Or = livres[m][sorteioCel(gerador)];
+        const Coord& De = livres[m][sorteioCel(gerador)];
+        int tam = snprintf(linha, sizeof(linha), " %d %d %d %d\n", Or.lin, Or.col, De.lin, De.col);
+        buf += mapas[m];
+        buf.append(linha, tam);
+        if (buf.size() >= (1u << 16))
+        {
+            O.write(buf.data(), buf.size());
+            buf.clear();
+        }
+    }
+    O.write(buf.data(), buf.size());
+    return bool(O);
+}
@@ -0,0 +1,71 @@
+#ifndef _REPRODUCAO_H_
+#define _REPRODUCAO_H_
+
+#include <iostream>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include "labirinto.h"
+
+/// Numero de registros do log processados em cada lote da reproducao
+#define TAM_LOTE_REPRODUCAO 256
+/// Numero padrao de mapas mantidos na cache da reproducao
+#define CAP_CACHE_MAPAS 16
+
+/// Cache de mapas lidos de arquivos, identificados pelo nome do arquivo
+/// Guarda no maximo "capacidade" mapas; quando cheia, descarta o usado ha mais tempo (LRU)
+/// Os mapas sao compartilhados (shared_ptr): um mapa descartado continua valido para
+/// quem ainda o usa
+/// Nao eh segura para uso simultaneo por varias threads
+class CacheMapas
+{
+private:
+    typedef pair<string, shared_ptr<const Labirinto> > Entrada;
+
+    unsigned capacidade;
+    LayoutMapa layout;
+    /// Entradas, da usada mais recentemente para a usada ha mais tempo
+    list<Entrada> uso;
+    unordered_map<string, list<Entrada>::iterator> indice;
+    unsigned long acertos, faltas, preprocessados;
+
+public:
+    /// Cria uma cache vazia para cap mapas, lidos com o layout L
+    explicit CacheMapas(unsigned cap=CAP_CACHE_MAPAS, LayoutMapa L=LayoutMapa::LINHAS);
+
+    /// Retorna o mapa do arquivo nome_arq, lendo-o se nao estiver na cache
+    /// O arquivo pode estar na codificacao compacta ou no formato texto; se houver um
+    /// pre-processamento salvo ao lado dele (ver Labirinto::lerPreprocessamento), tambem eh lido
+    /// Retorna nullptr se o arquivo nao puder ser lido (a falha tambem fica na cache)
+    shared_ptr<const Labirinto> obter(const string& nome_arq);
+
+    /// Estatisticas de uso
+    unsigned long getAcertos() const;
+    unsigned long getFaltas() const;
+    /// Numero de mapas lidos com pre-processamento
+    unsigned long getPreprocessados() const;
+};
+
+/// Reproduz um log de consultas
+/// Cada linha do log tem um registro "mapa linOr colOr linDe colDe", em que mapa eh o nome
+/// do arquivo do mapa; linhas vazias e iniciadas por '#' sao ignoradas
+/// Para cada registro, escreve em "saida" uma linha "numero estado comprimento", na ordem do log
+/// (numero eh a posicao do registro no log, a partir de 0; registros invalidos ou de mapas
+/// que nao puderam ser lidos tem estado REJEITADA)
+/// O processamento eh feito em tres estagios, em lotes de TAM_LOTE_REPRODUCAO registros:
+/// a leitura do log (com a cache de mapas), numThreads threads que resolvem as consultas
+/// (cada uma com o seu contexto de busca) e a escrita, que restaura a ordem dos lotes
+/// As consultas sobre mapas pre-processados usam buscaPreprocessada; as demais, buscaCaminho
+/// Ao final, escreve em "relatorio" a vazao, os totais por estado, o uso da cache e
+/// os percentis das latencias (da busca e da leitura do registro ate a escrita do resultado)
+/// Retorna false se a saida nao puder ser escrita
+bool reproduzLog(istream& log, ostream& saida, ostream& relatorio, unsigned numThreads,
+                 unsigned capCache=CAP_CACHE_MAPAS);
+
+/// Gera um log de numConsultas consultas aleatorias (origem e destino livres) sobre os mapas
+/// dos arquivos em "mapas", sorteados a cada registro; mesma semente, mesmo log
+/// Retorna false se algum mapa nao puder ser lido
+bool geraLog(ostream& O, const vector<string>& mapas, unsigned long numConsultas, unsigned semente=1);
+
+#endif // _REPRODUCAO_H_
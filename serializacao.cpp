@@ -0,0 +1,358 @@
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "serializacao.h"
+#include "binario.h"
+
+using namespace std;
+
+/* ***************** */
+/* CAMINHOS          */
+/* ***************** */
+
+/// Codigo (0 a 7) da direcao de um passo unitario (<0 se nao for unitario)
+static int dir2codigo(const Coord& D)
+{
+    if (D.lin<-1 || D.lin>1 || D.col<-1 || D.col>1 || D == Coord(0,0)) return -1;
+    int k = 3*(D.lin+1) + (D.col+1);
+    // Pula o codigo 4 (passo nulo)
+    return (k > 4 ? k-1 : k);
+}
+
+/// Direcao correspondente a um codigo
+static Coord codigo2dir(int k)
+{
+    if (k >= 4) k++;
+    return Coord(k/3-1, k%3-1);
+}
+
+/// Retorna o tamanho em bytes da codificacao de um caminho com numPontos pontos
+size_t tamanhoCaminho(size_t numPontos)
+{
+    size_t numPassos = (numPontos > 0 ? numPontos-1 : 0);
+    return TAM_CABEC_CAMINHO + (3*numPassos+7)/8;
+}
+
+/// Escreve a codificacao do caminho em buf
+size_t escreverCaminho(const vector<Coord>& caminho, unsigned char* buf, size_t tam)
+{
+    size_t total = tamanhoCaminho(caminho.size());
+    if (caminho.empty() || buf == nullptr || tam < total) return 0;
+
+    buf[0] = 'C';
+    buf[1] = 'A';
+    buf[2] = 'M';
+    buf[3] = 0;
+    escreveU32(buf+4, caminho.front().lin);
+    escreveU32(buf+8, caminho.front().col);
+    escreveU32(buf+12, caminho.size()-1);
+
+    unsigned char* p = buf+TAM_CABEC_CAMINHO;
+    fill(p, buf+total, 0);
+    for (size_t k=1; k<caminho.size(); k++)
+    {
+        int cod = dir2codigo(caminho[k]-caminho[k-1]);
+        if (cod < 0) return 0;
+        size_t bit = 3*(k-1);
+        // O codigo pode ocupar dois bytes consecutivos
+        p[bit/8] |= (cod << (bit%8)) & 0xFF;
+        if (bit%8 > 5) p[bit/8+1] |= cod >> (8-bit%8);
+    }
+    return total;
+}
+
+/// Leh um caminho da codificacao em buf
+bool lerCaminho(const unsigned char* buf, size_t tam, vector<Coord>& caminho)
+{
+    caminho.clear();
+    if (buf == nullptr || tam < TAM_CABEC_CAMINHO ||
+            buf[0] != 'C' || buf[1] != 'A' || buf[2] != 'M' || buf[3] != 0)
+    {
+        return false;
+    }
+    size_t numPassos = leU32(buf+12);
+    if (tam < tamanhoCaminho(numPassos+1)) return false;
+
+    caminho.reserve(numPassos+1);
+    caminho.push_back(Coord(leU32(buf+4), leU32(buf+8)));
+    const unsigned char* p = buf+TAM_CABEC_CAMINHO;
+    for (size_t k=0; k<numPassos; k++)
+    {
+        size_t bit = 3*k;
+        unsigned cod = p[bit/8] >> (bit%8);
+        if (bit%8 > 5) cod |= p[bit/8+1] << (8-bit%8);
+        caminho.push_back(caminho.back() + codigo2dir(cod & 7));
+    }
+    return true;
+}
+
+/* ******************** */
+/* CLASSE VISAOMAPABITS */
+/* ******************** */
+
+VisaoMapaBits::VisaoMapaBits(): dados(nullptr), NL(0), NC(0), bytesLinha(0) {}
+
+/// Associa a visao a codificacao em buf
+bool VisaoMapaBits::abrir(const unsigned char* buf, size_t tam)
+{
+    dados = nullptr;
+    NL = NC = bytesLinha = 0;
+    if (buf == nullptr || tam < TAM_CABEC_COMPACTO ||
+            buf[0] != 'L' || buf[1] != 'A' || buf[2] != 'B' || buf[3] != 'B')
+    {
+        return false;
+    }
+    unsigned numL = leU32(buf+4), numC = leU32(buf+8);
+    if (leU32(buf+12) != size_t(numL)*((numC+7)/8) ||
+            tam-TAM_CABEC_COMPACTO < size_t(numL)*((numC+7)/8))
+    {
+        return false;
+    }
+    NL = numL;
+    NC = numC;
+    bytesLinha = (NC+7)/8;
+    dados = buf+TAM_CABEC_COMPACTO;
+    return true;
+}
+
+unsigned VisaoMapaBits::getNumLin() const
+{
+    return NL;
+}
+
+unsigned VisaoMapaBits::getNumCol() const
+{
+    return NC;
+}
+
+/// Testa se a celula C estah dentro do mapa e livre
+bool VisaoMapaBits::celulaLivre(const Coord& C) const
+{
+    if (!C.valida() || C.lin >= int(NL) || C.col >= int(NC)) return false;
+    return (dados[size_t(C.lin)*bytesLinha + C.col/8] >> (C.col%8)) & 1;
+}
+
+/* ***************************** */
+/* CLASSE MEMORIACOMPARTILHADA   */
+/* ***************************** */
+
+MemoriaCompartilhada::MemoriaCompartilhada(): nome(), dados(nullptr), tam(0), criador(false)
+#ifdef _WIN32
+    , handle(nullptr)
+#endif
+{}
+
+MemoriaCompartilhada::~MemoriaCompartilhada()
+{
+    fechar();
+}
+
+/// Cria um segmento novo com tam_seg bytes
+bool MemoriaCompartilhada::criar(const string& nome_seg, size_t tam_seg)
+{
+    fechar();
+    if (tam_seg == 0) return false;
+#ifdef _WIN32
+    handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                DWORD(uint64_t(tam_seg) >> 32), DWORD(tam_seg & 0xFFFFFFFF),
+                                nome_seg.c_str());
+    if (handle == nullptr) return false;
+    dados = (unsigned char*)MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, tam_seg);
+    if (dados == nullptr)
+    {
+        CloseHandle(handle);
+        handle = nullptr;
+        return false;
+    }
+#else
+    int fd = shm_open(nome_seg.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, tam_seg) != 0)
+    {
+        close(fd);
+        shm_unlink(nome_seg.c_str());
+        return false;
+    }
+    void* p = mmap(nullptr, tam_seg, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(nome_seg.c_str());
+        return false;
+    }
+    dados = (unsigned char*)p;
+#endif
+    nome = nome_seg;
+    tam = tam_seg;
+    criador = true;
+    return true;
+}
+
+/// Abre um segmento existente
+bool MemoriaCompartilhada::abrir(const string& nome_seg)
+{
+    fechar();
+#ifdef _WIN32
+    handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, nome_seg.c_str());
+    if (handle == nullptr) return false;
+    dados = (unsigned char*)MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (dados == nullptr)
+    {
+        CloseHandle(handle);
+        handle = nullptr;
+        return false;
+    }
+    // O tamanho eh arredondado para um multiplo do tamanho da pagina
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(dados, &info, sizeof(info));
+    tam = info.RegionSize;
+#else
+    int fd = shm_open(nome_seg.c_str(), O_RDWR, 0600);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    dados = (unsigned char*)p;
+    tam = st.st_size;
+#endif
+    nome = nome_seg;
+    criador = false;
+    return true;
+}
+
+/// Desmapeia o segmento (e o remove, se foi criado por este objeto)
+void MemoriaCompartilhada::fechar()
+{
+    if (dados == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(dados);
+    CloseHandle(handle);
+    handle = nullptr;
+#else
+    munmap(dados, tam);
+    if (criador) shm_unlink(nome.c_str());
+#endif
+    dados = nullptr;
+    tam = 0;
+    criador = false;
+    nome.clear();
+}
+
+unsigned char* MemoriaCompartilhada::getDados() const
+{
+    return dados;
+}
+
+size_t MemoriaCompartilhada::getTamanho() const
+{
+    return tam;
+}
+
+/* ************************ */
+/* VERIFICACAO IDA E VOLTA  */
+/* ************************ */
+
+/// Testa se dois mapas tem as mesmas dimensoes e os mesmos obstaculos
+static bool mesmosObstaculos(const Labirinto& A, const Labirinto& B)
+{
+    if (A.getNumLin() != B.getNumLin() || A.getNumCol() != B.getNumCol()) return false;
+    for (unsigned i=0; i<A.getNumLin(); i++) for (unsigned j=0; j<A.getNumCol(); j++)
+        {
+            if (A.celulaLivre(Coord(i,j)) != B.celulaLivre(Coord(i,j))) return false;
+        }
+    return true;
+}
+
+/// Verifica a ida e volta das codificacoes compactas contra o formato texto
+bool verificaCompacto(ostream& O, const string& nome_arq)
+{
+    Labirinto texto;
+    if (!texto.ler(nome_arq))
+    {
+        O << "Erro na leitura do arquivo " << nome_arq << endl;
+        return false;
+    }
+    bool ok = true;
+
+    // Nome (unico) dos segmentos compartilhados
+#ifdef _WIN32
+    string prefixo = "Local\\labirinto_";
+#else
+    string prefixo = "/labirinto_";
+#endif
+    prefixo += to_string(chrono::steady_clock::now().time_since_epoch().count());
+
+    FormatoCompacto formatos[] = {FormatoCompacto::BITS, FormatoCompacto::RLE};
+    for (FormatoCompacto F : formatos)
+    {
+        string formato = (F == FormatoCompacto::BITS ? "BITS" : "RLE");
+
+        // Escreve diretamente no segmento e leh de um segundo mapeamento dele,
+        // como faria outro processo
+        MemoriaCompartilhada escrita, leitura;
+        size_t tam = texto.tamanhoCompacto(F);
+        Labirinto compacto;
+        bool confere = escrita.criar(prefixo + formato, tam) &&
+                       texto.escreverCompacto(F, escrita.getDados(), tam) == tam &&
+                       leitura.abrir(prefixo + formato) &&
+                       compacto.lerCompacto(leitura.getDados(), tam) &&
+                       mesmosObstaculos(texto, compacto);
+
+        // No formato BITS, confere tambem a visao sem copia
+        if (confere && F == FormatoCompacto::BITS)
+        {
+            VisaoMapaBits V;
+            confere = V.abrir(leitura.getDados(), tam);
+            for (unsigned i=0; confere && i<texto.getNumLin(); i++)
+                for (unsigned j=0; confere && j<texto.getNumCol(); j++)
+                {
+                    confere = (V.celulaLivre(Coord(i,j)) == texto.celulaLivre(Coord(i,j)));
+                }
+        }
+
+        O << formato << ' ' << tam << " bytes\t" << (confere ? "OK" : "ERRO") << endl;
+        ok = ok && confere;
+    }
+
+    // Caminho entre duas celulas livres sorteadas
+    vector<Coord> livres;
+    for (unsigned i=0; i<texto.getNumLin(); i++) for (unsigned j=0; j<texto.getNumCol(); j++)
+        {
+            if (texto.celulaLivre(Coord(i,j))) livres.push_back(Coord(i,j));
+        }
+    if (!livres.empty())
+    {
+        vector<Coord> caminho, lido;
+        int NA, NF;
+        srand(1);
+        texto.buscaCaminho(livres[rand()%livres.size()], livres[rand()%livres.size()],
+                           caminho, NA, NF);
+        if (!caminho.empty())
+        {
+            MemoriaCompartilhada seg;
+            size_t tam = tamanhoCaminho(caminho.size());
+            bool confere = seg.criar(prefixo + "CAMINHO", tam) &&
+                           escreverCaminho(caminho, seg.getDados(), tam) == tam &&
+                           lerCaminho(seg.getDados(), tam, lido) &&
+                           lido == caminho;
+            O << "CAMINHO " << caminho.size() << " pontos, " << tam << " bytes\t"
+              << (confere ? "OK" : "ERRO") << endl;
+            ok = ok && confere;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,86 @@
+#ifndef _SERIALIZACAO_H_
+#define _SERIALIZACAO_H_
+
+#include <iostream>
+#include <string>
+#include "labirinto.h"
+
+/// Codificacao compacta de caminhos
+/// Cabecalho de TAM_CABEC_CAMINHO bytes: 'C' 'A' 'M' 0 lin col <numero de passos>
+/// (inteiros de 32 bits little-endian), seguido de um codigo de 3 bits por passo
+/// (a direcao do passo, ver dir2codigo), empacotados a partir do bit menos significativo
+/// Soh codifica caminhos em que cada passo vai para uma celula vizinha (caminhos do A*)
+#define TAM_CABEC_CAMINHO 16
+
+/// Retorna o tamanho em bytes da codificacao de um caminho com numPontos pontos
+size_t tamanhoCaminho(size_t numPontos);
+/// Escreve a codificacao do caminho em buf (com tam bytes)
+/// Retorna o numero de bytes escritos (0 em caso de erro ou de passo nao unitario)
+size_t escreverCaminho(const vector<Coord>& caminho, unsigned char* buf, size_t tam);
+/// Leh um caminho da codificacao em buf (com tam bytes)
+/// Retorna true em caso de leitura bem sucedida
+bool lerCaminho(const unsigned char* buf, size_t tam, vector<Coord>& caminho);
+
+/// Visao (sem copia) de um mapa codificado no formato FormatoCompacto::BITS,
+/// por exemplo em um segmento de memoria compartilhada
+/// Os dados devem continuar validos enquanto a visao for usada
+class VisaoMapaBits
+{
+private:
+    const unsigned char* dados;
+    unsigned NL, NC, bytesLinha;
+
+public:
+    VisaoMapaBits();
+
+    /// Associa a visao a codificacao em buf (com tam bytes)
+    /// Retorna false se buf nao contem um mapa no formato BITS
+    bool abrir(const unsigned char* buf, size_t tam);
+
+    unsigned getNumLin() const;
+    unsigned getNumCol() const;
+    /// Testa se a celula C estah dentro do mapa e livre
+    bool celulaLivre(const Coord& C) const;
+};
+
+/// Segmento de memoria compartilhada entre processos de um mesmo computador,
+/// identificado por um nome
+/// O segmento eh desmapeado na destruicao; quem o criou tambem o remove
+class MemoriaCompartilhada
+{
+private:
+    string nome;
+    unsigned char* dados;
+    size_t tam;
+    bool criador;
+#ifdef _WIN32
+    void* handle;
+#endif
+
+    /// Nao pode ser copiada
+    MemoriaCompartilhada(const MemoriaCompartilhada&);
+    MemoriaCompartilhada& operator=(const MemoriaCompartilhada&);
+
+public:
+    MemoriaCompartilhada();
+    ~MemoriaCompartilhada();
+
+    /// Cria um segmento novo com tam_seg bytes
+    bool criar(const string& nome_seg, size_t tam_seg);
+    /// Abre um segmento existente (criado por outro processo)
+    bool abrir(const string& nome_seg);
+    /// Desmapeia o segmento (e o remove, se foi criado por este objeto)
+    void fechar();
+
+    unsigned char* getDados() const;
+    size_t getTamanho() const;
+};
+
+/// Verifica a ida e volta das codificacoes compactas contra o formato texto:
+/// leh o mapa do arquivo texto nome_arq, codifica nos formatos BITS e RLE (em memoria
+/// compartilhada), decodifica e compara celula a celula; faz o mesmo com um caminho
+/// calculado entre celulas livres sorteadas
+/// Escreve em O os tamanhos das codificacoes e retorna true se tudo conferir
+bool verificaCompacto(std::ostream& O, const string& nome_arq);
+
+#endif // _SERIALIZACAO_H_
@@ -0,0 +1,288 @@
+#include <iomanip>
+#include <algorithm>
+#include <random>
+
+#include "servico.h"
+
+using namespace std;
+
+/* ***************** */
+/* CONSULTA/RESPOSTA */
+/* ***************** */
+
+Consulta::Consulta(): orig(), dest(), prazoMs(0.0) {}
+
+Consulta::Consulta(const Coord& O, const Coord& D, double prazo):
+    orig(O), dest(D), prazoMs(prazo) {}
+
+string estadoResposta2string(EstadoResposta E)
+{
+    switch(E)
+    {
+    case EstadoResposta::ENCONTRADO:
+        return "ENCONTRADO";
+    case EstadoResposta::SEM_CAMINHO:
+        return "SEM_CAMINHO";
+    case EstadoResposta::CANCELADA:
+        return "CANCELADA";
+    case EstadoResposta::EXPIRADA:
+        return "EXPIRADA";
+    case EstadoResposta::REJEITADA:
+        return "REJEITADA";
+    case EstadoResposta::SEM_MEMORIA:
+        return "SEM_MEMORIA";
+    default:
+        break;
+    }
+    return "??";
+}
+
+Resposta::Resposta(): estado(EstadoResposta::SEM_CAMINHO), compr(-1.0), caminho(),
+    NA(0), NF(0), latenciaMs(0.0) {}
+
+/// Pede o cancelamento da consulta
+void Pedido::cancelar()
+{
+    if (cancelamento) cancelamento->store(true);
+}
+
+/* ********************** */
+/* CLASSE SERVICOCONSULTAS */
+/* ********************** */
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Cria o servico sobre um mapa fixo
+ServicoConsultas::ServicoConsultas(shared_ptr<const Labirinto> M, unsigned numThreads,
+                                   unsigned capFila, unsigned periodoTeste):
+    mapa(M), versoes(), fila(capFila), trabalhadores(), periodo(max(periodoTeste, 1u))
+{
+    iniciar(numThreads);
+}
+
+/// Cria o servico sobre as versoes de um mapa
+ServicoConsultas::ServicoConsultas(shared_ptr<const VersoesMapa> V, unsigned numThreads,
+                                   unsigned capFila, unsigned periodoTeste):
+    mapa(), versoes(V), fila(capFila), trabalhadores(), periodo(max(periodoTeste, 1u))
+{
+    iniciar(numThreads);
+}
+
+/// Dispara as threads trabalhadoras
+void ServicoConsultas::iniciar(unsigned numThreads)
+{
+    for (unsigned k=0; k<max(numThreads, 1u); k++)
+    {
+        trabalhadores.push_back(thread(&ServicoConsultas::trabalhar, this));
+    }
+}
+
+/// Termina as consultas pendentes e as threads
+ServicoConsultas::~ServicoConsultas()
+{
+    fila.fechar();
+    for (thread& T : trabalhadores) T.join();
+}
+
+/// Laco de cada thread trabalhadora: retira tarefas ate a fila ser fechada e esvaziada
+/// Cada thread tem o seu contexto de busca, reusado em todas as tarefas
+void ServicoConsultas::trabalhar()
+{
+    ContextoBusca ctx;
+    unique_ptr<Tarefa> T;
+    while (fila.retirar(T))
+    {
+        responder(*T, resolver(*T, ctx));
+        T.reset();
+    }
+}
+
+/// Resolve uma tarefa
+/// O cancelamento e o prazo sao testados antes de iniciar e durante a busca
+Resposta ServicoConsultas::resolver(Tarefa& T, ContextoBusca& ctx) const
+{
+    Resposta R;
+
+    Interrupcao I;
+    I.cancelada = T.cancelamento.get();
+    I.periodo = periodo;
+    if (T.consulta.prazoMs > 0.0)
+    {
+        I.temPrazo = true;
+        I.prazo = T.submissao + chrono::duration_cast<chrono::steady_clock::duration>(
+                      chrono::duration<double, milli>(T.consulta.prazoMs));
+    }
+
+    if (I.interromper()) R.compr = COMPR_INTERROMPIDA;
+    else R.compr = T.mapa->buscaCaminho(T.consulta.orig, T.consulta.dest, R.caminho, R.NA, R.NF, &I, &ctx);
+
+    if (R.compr == COMPR_INTERROMPIDA)
+    {
+        R.estado = (T.cancelamento->load() ? EstadoResposta::CANCELADA : EstadoResposta::EXPIRADA);
+        R.caminho.clear();
+    }
+    else if (R.compr == COMPR_SEM_MEMORIA)
+    {
+        R.estado = EstadoResposta::SEM_MEMORIA;
+    }
+    else
+    {
+        R.estado = (R.compr >= 0.0 ? EstadoResposta::ENCONTRADO : EstadoResposta::SEM_CAMINHO);
+    }
+    return R;
+}
+
+/// Entrega a resposta de uma tarefa (pela promessa ou pela funcao de retorno)
+void ServicoConsultas::responder(Tarefa& T, const Resposta& R)
+{
+    Resposta RR(R);
+    RR.latenciaMs = milissegundos(T.submissao);
+    if (T.retorno) T.retorno(RR);
+    else T.promessa.set_value(RR);
+}
+
+/// Coloca uma tarefa na fila ou, se nao for possivel, responde REJEITADA
+void ServicoConsultas::enfileirar(unique_ptr<Tarefa> T, bool esperar)
+{
+    Tarefa* prov = T.get();
+    if (!fila.inserir(move(T), esperar))
+    {
+        // Se a insercao falhou, a tarefa nao foi movida para a fila
+        Resposta R;
+        R.estado = EstadoResposta::REJEITADA;
+        responder(*prov, R);
+    }
+}
+
+/// Cria uma tarefa para a consulta C sobre a versao corrente do mapa
+unique_ptr<ServicoConsultas::Tarefa> ServicoConsultas::criarTarefa(const Consulta& C) const
+{
+    unique_ptr<Tarefa> T(new Tarefa);
+    T->consulta = C;
+    T->cancelamento = make_shared<atomic<bool> >(false);
+    T->submissao = chrono::steady_clock::now();
+    T->mapa = (versoes ? versoes->versao() : mapa);
+    return T;
+}
+
+/// Submete uma consulta e retorna a resposta futura
+Pedido ServicoConsultas::submeter(const Consulta& C, bool esperar)
+{
+    unique_ptr<Tarefa> T = criarTarefa(C);
+
+    Pedido P;
+    P.resposta = T->promessa.get_future();
+    P.cancelamento = T->cancelamento;
+    enfileirar(move(T), esperar);
+    return P;
+}
+
+/// Submete uma consulta com funcao de retorno
+Cancelamento ServicoConsultas::submeter(const Consulta& C, function<void(const Resposta&)> retorno,
+                                        bool esperar)
+{
+    unique_ptr<Tarefa> T = criarTarefa(C);
+    T->retorno = retorno;
+
+    Cancelamento canc = T->cancelamento;
+    enfileirar(move(T), esperar);
+    return canc;
+}
+
+/// Numero de consultas aguardando na fila
+unsigned ServicoConsultas::pendentes()
+{
+    return fila.size();
+}
+
+/* ***************** */
+/* GERADOR DE CARGA  */
+/* ***************** */
+
+/// Gerador de carga sintetica para o servico
+void geradorCarga(ostream& O, shared_ptr<const Labirinto> M, unsigned numConsultas,
+                  unsigned numThreads, unsigned numProdutores,
+                  double percCancel, double prazoMs)
+{
+    if (!M || M->empty())
+    {
+        O << "Mapa vazio...\n";
+        return;
+    }
+
+    // Celulas livres, para sortear as origens e destinos
+    vector<Coord> livres;
+    for (unsigned i=0; i<M->getNumLin(); i++) for (unsigned j=0; j<M->getNumCol(); j++)
+        {
+            if (M->celulaLivre(Coord(i,j))) livres.push_back(Coord(i,j));
+        }
+    if (livres.empty())
+    {
+        O << "Mapa sem celulas livres...\n";
+        return;
+    }
+
+    numProdutores = max(numProdutores, 1u);
+    vector<vector<Pedido> > pedidos(numProdutores);
+
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    {
+        ServicoConsultas S(M, numThreads);
+
+        // Cada produtor submete a sua parte das consultas
+        vector<thread> produtores;
+        for (unsigned p=0; p<numProdutores; p++)
+        {
+            produtores.push_back(thread([&, p]
+            {
+                mt19937 gerador(p+1);
+                uniform_int_distribution<unsigned> sorteioCel(0, livres.size()-1);
+                uniform_real_distribution<double> sorteioCanc(0.0, 1.0);
+                for (unsigned k=p; k<numConsultas; k+=numProdutores)
+                {
+                    Consulta C(livres[sorteioCel(gerador)], livres[sorteioCel(gerador)], prazoMs);
+                    pedidos[p].push_back(S.submeter(C));
+                    if (sorteioCanc(gerador) < percCancel) pedidos[p].back().cancelar();
+                }
+            }));
+        }
+        for (thread& T : produtores) T.join();
+
+        // Espera todas as respostas antes de destruir o servico
+        for (vector<Pedido>& V : pedidos) for (Pedido& P : V) P.resposta.wait();
+    }
+    double tTotal = milissegundos(t1);
+
+    // Totais e latencias
+    unsigned totais[NUM_ESTADOS_RESPOSTA] = {0};
+    vector<double> latencias;
+    for (vector<Pedido>& V : pedidos) for (Pedido& P : V)
+        {
+            Resposta R = P.resposta.get();
+            totais[int(R.estado)]++;
+            latencias.push_back(R.latenciaMs);
+        }
+    sort(latencias.begin(), latencias.end());
+
+    O << "CARGA " << numConsultas << " consultas, " << numThreads << " threads, "
+      << numProdutores << " produtores" << endl;
+    O << fixed << setprecision(3)
+      << "Tempo=" << tTotal << "ms\t Vazao=" << 1000.0*numConsultas/tTotal << " consultas/s" << endl;
+    for (int e=0; e<NUM_ESTADOS_RESPOSTA; e++)
+    {
+        O << estadoResposta2string(EstadoResposta(e)) << '=' << totais[e] << ' ';
+    }
+    O << endl;
+    if (!latencias.empty())
+    {
+        O << "Latencia(ms): p50=" << latencias[latencias.size()/2]
+          << " p99=" << latencias[(latencias.size()*99)/100]
+          << " max=" << latencias.back() << endl;
+    }
+}
@@ -0,0 +1,150 @@
+#ifndef _SERVICO_H_
+#define _SERVICO_H_
+
+#include <iostream>
+#include <memory>
+#include <future>
+#include <functional>
+#include <thread>
+#include "labirinto.h"
+#include "fila.h"
+#include "versoes.h"
+#include "arena.h"
+
+/// Uma consulta ao servico: caminho de orig a dest
+struct Consulta
+{
+    Coord orig, dest;
+    /// Tempo maximo para a resposta, a partir da submissao (<=0 = sem prazo)
+    double prazoMs;
+
+    Consulta();
+    Consulta(const Coord& O, const Coord& D, double prazo=0.0);
+};
+
+/// Os possiveis resultados de uma consulta
+enum class EstadoResposta
+{
+    ENCONTRADO,
+    SEM_CAMINHO,
+    CANCELADA,
+    EXPIRADA,
+    REJEITADA,
+    SEM_MEMORIA
+};
+
+/// Numero de estados de resposta
+#define NUM_ESTADOS_RESPOSTA 6
+
+// Funcao para converter um estado de resposta em uma string que o represente
+string estadoResposta2string(EstadoResposta E);
+
+/// A resposta a uma consulta
+struct Resposta
+{
+    EstadoResposta estado;
+    /// Comprimento do caminho (<0 se nao foi encontrado)
+    double compr;
+    /// As celulas do caminho, de orig a dest
+    vector<Coord> caminho;
+    /// Numero de nos em aberto e em fechado ao termino da busca
+    int NA, NF;
+    /// Tempo entre a submissao e a resposta, em milissegundos
+    double latenciaMs;
+
+    Resposta();
+};
+
+/// Sinalizador de cancelamento de uma consulta, compartilhado entre quem a submeteu e o servico
+typedef shared_ptr<atomic<bool> > Cancelamento;
+
+/// Uma consulta submetida: a resposta futura e o sinalizador de cancelamento
+struct Pedido
+{
+    future<Resposta> resposta;
+    Cancelamento cancelamento;
+
+    /// Pede o cancelamento da consulta (cooperativo: a busca termina no proximo teste)
+    void cancelar();
+};
+
+/// Servico assincrono de consultas de caminho sobre um mapa
+/// As consultas passam por uma fila limitada e sao resolvidas por um conjunto de threads
+/// Com um mapa fixo, ele nao pode ser alterado enquanto o servico estiver ativo
+/// Com versoes de um mapa, cada consulta usa a versao corrente no momento da submissao
+class ServicoConsultas
+{
+private:
+    /// Uma consulta na fila, com o que eh necessario para responde-la
+    struct Tarefa
+    {
+        Consulta consulta;
+        Cancelamento cancelamento;
+        chrono::steady_clock::time_point submissao;
+        /// A versao do mapa usada pela consulta
+        shared_ptr<const Labirinto> mapa;
+        /// Somente um dos dois eh usado: a promessa ou a funcao de retorno
+        promise<Resposta> promessa;
+        function<void(const Resposta&)> retorno;
+    };
+
+    /// O mapa fixo ou as versoes do mapa (somente um dos dois eh usado)
+    shared_ptr<const Labirinto> mapa;
+    shared_ptr<const VersoesMapa> versoes;
+    FilaLimitada<unique_ptr<Tarefa> > fila;
+    vector<thread> trabalhadores;
+    /// Numero de nos expandidos entre dois testes de cancelamento/prazo
+    unsigned periodo;
+
+    /// Laco de cada thread trabalhadora
+    void trabalhar();
+    /// Resolve uma tarefa, usando o contexto de busca da thread
+    Resposta resolver(Tarefa& T, ContextoBusca& ctx) const;
+    /// Entrega a resposta de uma tarefa
+    static void responder(Tarefa& T, const Resposta& R);
+    /// Cria uma tarefa para a consulta C sobre a versao corrente do mapa
+    unique_ptr<Tarefa> criarTarefa(const Consulta& C) const;
+    /// Coloca uma tarefa na fila ou, se nao for possivel, responde REJEITADA
+    /// (na thread de quem chamou, pois a fila nao aceita a tarefa)
+    void enfileirar(unique_ptr<Tarefa> T, bool esperar);
+    /// Dispara as threads trabalhadoras
+    void iniciar(unsigned numThreads);
+
+public:
+    /// Cria o servico sobre o mapa M, com numThreads threads e uma fila de capFila consultas
+    /// A busca testa o cancelamento e o prazo a cada "periodoTeste" nos expandidos
+    ServicoConsultas(shared_ptr<const Labirinto> M, unsigned numThreads,
+                     unsigned capFila=1024, unsigned periodoTeste=256);
+    /// Cria o servico sobre as versoes V de um mapa
+    ServicoConsultas(shared_ptr<const VersoesMapa> V, unsigned numThreads,
+                     unsigned capFila=1024, unsigned periodoTeste=256);
+
+    /// Termina as consultas pendentes e as threads
+    ~ServicoConsultas();
+
+    /// Submete uma consulta e retorna a resposta futura
+    /// Se a fila estiver cheia, espera (esperar=true) ou responde REJEITADA (esperar=false)
+    Pedido submeter(const Consulta& C, bool esperar=true);
+
+    /// Submete uma consulta; "retorno" eh chamada com a resposta por uma thread do servico,
+    /// exceto quando a consulta eh rejeitada (fila cheia com esperar=false, ou servico
+    /// terminado): nesse caso, eh chamada por esta funcao, na thread de quem submeteu
+    /// Retorna o sinalizador de cancelamento da consulta
+    Cancelamento submeter(const Consulta& C, function<void(const Resposta&)> retorno,
+                          bool esperar=true);
+
+    /// Numero de consultas aguardando na fila
+    unsigned pendentes();
+};
+
+/// Gerador de carga sintetica para o servico
+/// Submete numConsultas consultas aleatorias (origem e destino livres) ao servico com
+/// numThreads threads, a partir de numProdutores threads produtoras
+/// Uma fracao percCancel das consultas eh cancelada logo apos a submissao
+/// Cada consulta tem prazo prazoMs (<=0 = sem prazo)
+/// Escreve em O a vazao, os totais por estado e as latencias
+void geradorCarga(std::ostream& O, shared_ptr<const Labirinto> M, unsigned numConsultas,
+                  unsigned numThreads, unsigned numProdutores=2,
+                  double percCancel=0.1, double prazoMs=0.0);
+
+#endif // _SERVICO_H_
@@ -0,0 +1,428 @@
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+
+#include "verificacao.h"
+#include "arena.h"
+#include "contracao.h"
+#include "onda.h"
+#include "paralelo.h"
+
+using namespace std;
+
+/// Tolerancia na comparacao de comprimentos
+#define EPS_VERIF 1e-6
+/// Numero de threads da busca paralela nas verificacoes
+#define THREADS_VERIF 3
+/// Base do nome do arquivo temporario das verificacoes da leitura com janela
+/// (o nome eh exclusivo de cada chamada, ver nomeTemporario)
+#define ARQ_VERIF "verificacao.tmp"
+/// Um a cada PERIODO_MAPA_LARGO mapas de verificaSolvers tem de LARGURA_MAPA_LARGO a
+/// LARGURA_MAPA_LARGO+63 colunas, qualquer que seja dimMax: linhas de mais de 4 palavras
+/// de 64 bits nas mascaras de BuscaOnda (deslocamentos entre palavras e passo AVX2)
+#define PERIODO_MAPA_LARGO 10
+#define LARGURA_MAPA_LARGO 257
+
+/// Os modos verificados
+enum ModoVerif
+{
+    REFERENCIA,
+    BUSCA,
+    MAIS_PROXIMO,
+    MULTIPLOS_ALVOS,
+    PREPROCESSADO,
+    ONDA_DISTANCIA,
+    ONDA_ALCANCAVEL,
+    HDA,
+    JANELA,
+    THETA,
+    LAZY_THETA,
+    SUAVIZADO,
+    CODIFICACAO,
+    NUM_MODOS_VERIF
+};
+
+static const char* nomeModo[NUM_MODOS_VERIF] =
+{
+    "calculaCaminho", "buscaCaminho", "buscaMaisProximo", "multiplos alvos", "preprocessado",
+    "onda distancia", "onda alcancavel", "HDA*", "janela", "Theta*", "Lazy Theta*", "suavizado",
+    "codificacao"
+};
+
+/// Contagem de testes e falhas de cada modo
+struct ContagemVerif
+{
+    unsigned long testes[NUM_MODOS_VERIF];
+    unsigned long falhas[NUM_MODOS_VERIF];
+    /// Caminhos de qualquer angulo mais longos que o do A* (permitido, mas contado)
+    unsigned long maisLongos[NUM_MODOS_VERIF];
+
+    ContagemVerif()
+    {
+        fill(testes, testes+NUM_MODOS_VERIF, 0);
+        fill(falhas, falhas+NUM_MODOS_VERIF, 0);
+        fill(maisLongos, maisLongos+NUM_MODOS_VERIF, 0);
+    }
+};
+
+/* ************************* */
+/* REFERENCIA E PROPRIEDADES */
+/* ************************* */
+
+/// Distancias de Or a todas as celulas (infinito = inalcancavel), por um Dijkstra simples
+/// sobre as coordenadas: nao usa indices, layouts, heuristicas nem contextos de busca
+static vector<double> distanciasReferencia(const Labirinto& L, const Coord& Or)
+{
+    const unsigned NL = L.getNumLin(), NC = L.getNumCol();
+    vector<double> dist(NL*NC, numeric_limits<double>::infinity());
+    typedef pair<double,unsigned> Entrada;
+    priority_queue<Entrada, vector<Entrada>, greater<Entrada> > fila;
+
+    dist[NC*Or.lin+Or.col] = 0.0;
+    fila.push(Entrada(0.0, NC*Or.lin+Or.col));
+    while (!fila.empty())
+    {
+        Entrada E = fila.top();
+        fila.pop();
+        if (E.first > dist[E.second]) continue;
+        Coord pos(E.second/NC, E.second%NC);
+        for (int dl=-1; dl<2; dl++) for (int dc=-1; dc<2; dc++)
+            {
+                Coord prox(pos.lin+dl, pos.col+dc);
+                if ((dl == 0 && dc == 0) || !L.movimentoValido(pos, prox)) continue;
+                double d = E.first + ((dl != 0 && dc != 0) ? sqrt(2.0) : 1.0);
+                unsigned k = NC*prox.lin+prox.col;
+                if (d < dist[k])
+                {
+                    dist[k] = d;
+                    fila.push(Entrada(d, k));
+                }
+            }
+    }
+    return dist;
+}
+
+/// Distancia de referencia ate C (<0 = inalcancavel)
+static double distanciaEm(const Labirinto& L, const vector<double>& dist, const Coord& C)
+{
+    double d = dist[L.getNumCol()*C.lin+C.col];
+    return (d == numeric_limits<double>::infinity() ? -1.0 : d);
+}
+
+/// Testa se "pontos" eh um caminho valido de Or a De com o comprimento compr
+/// Nos modos de qualquer angulo, os pontos consecutivos devem ter linha de visada;
+/// nos demais, cada passo deve ser um movimento valido
+static bool caminhoValido(const Labirinto& L, const vector<Coord>& pontos,
+                          const Coord& Or, const Coord& De, double compr, bool qualquerAngulo)
+{
+    if (pontos.empty() || pontos.front() != Or || pontos.back() != De) return false;
+    double soma = 0.0;
+    for (unsigned k=1; k<pontos.size(); k++)
+    {
+        if (qualquerAngulo ? !L.linhaDeVisada(pontos[k-1], pontos[k])
+                : !L.movimentoValido(pontos[k-1], pontos[k]))
+        {
+            return false;
+        }
+        soma += norm(pontos[k]-pontos[k-1]);
+    }
+    return fabs(soma-compr) < EPS_VERIF;
+}
+
+/// Testa se dois mapas tem as mesmas dimensoes e os mesmos obstaculos
+static bool mesmosObstaculos(const Labirinto& A, const Labirinto& B)
+{
+    if (A.getNumLin() != B.getNumLin() || A.getNumCol() != B.getNumCol()) return false;
+    for (unsigned i=0; i<A.getNumLin(); i++) for (unsigned j=0; j<A.getNumCol(); j++)
+        {
+            if ((A.at(i,j) == EstadoCel::OBSTACULO) != (B.at(i,j) == EstadoCel::OBSTACULO)) return false;
+        }
+    return true;
+}
+
+/* ***************** */
+/* VERIFICACOES      */
+/* ***************** */
+
+/// Registra o resultado de um teste e, se falhou, escreve em O como reproduzi-lo
+static void registra(ostream& O, ContagemVerif& C, ModoVerif M, bool ok, const string& contexto,
+                     double esperado, double obtido)
+{
+    C.testes[M]++;
+    if (ok) return;
+    C.falhas[M]++;
+    O << "FALHA " << nomeModo[M] << ": " << contexto << fixed << setprecision(6)
+      << " esperado=" << esperado << " obtido=" << obtido << endl;
+}
+
+/// Compara um comprimento com o de referencia e confere o caminho (se houver)
+static bool confere(const Labirinto& L, double ref, double compr, const vector<Coord>& pontos,
+                    const Coord& Or, const Coord& De)
+{
+    if (ref < 0.0) return compr < 0.0;
+    return fabs(ref-compr) < EPS_VERIF && caminhoValido(L, pontos, Or, De, compr, false);
+}
+
+/// Verifica todos os modos em numConsultas consultas sorteadas no mapa L
+/// "descricao" identifica o mapa nas mensagens de falha
+static void verificaMapa(ostream& O, Labirinto& L, const string& descricao,
+                         unsigned numConsultas, ContagemVerif& C)
+{
+    // Ida e volta das codificacoes compactas e do formato texto
+    FormatoCompacto formatos[] = {FormatoCompacto::BITS, FormatoCompacto::RLE};
+    for (FormatoCompacto F : formatos)
+    {
+        vector<unsigned char> buf(L.tamanhoCompacto(F));
+        Labirinto M;
+        bool ok = L.escreverCompacto(F, buf.data(), buf.size()) == buf.size() &&
+                  M.lerCompacto(buf.data(), buf.size()) && mesmosObstaculos(L, M);
+        registra(O, C, CODIFICACAO, ok, descricao + (F == FormatoCompacto::BITS ? " BITS" : " RLE"), 1, ok);
+    }
+    {
+        stringstream S;
+        Labirinto M;
+        bool ok = L.salvar(S) && M.ler(S) && mesmosObstaculos(L, M);
+        registra(O, C, CODIFICACAO, ok, descricao + " texto", 1, ok);
+    }
+
+    // Estruturas montadas uma vez por mapa
+    L.preprocessar();
+    BuscaOnda B(L);
+    BuscaHDA H(L, THREADS_VERIF);
+    ContextoBusca ctx;
+    const string arqVerif = nomeTemporario(ARQ_VERIF);
+    bool temArquivo = L.salvarCompacto(arqVerif, FormatoCompacto::BITS);
+
+    vector<Coord> livres;
+    for (unsigned i=0; i<L.getNumLin(); i++) for (unsigned j=0; j<L.getNumCol(); j++)
+        {
+            if (L.celulaLivre(Coord(i,j))) livres.push_back(Coord(i,j));
+        }
+    if (livres.size() < 2) return;
+
+    for (unsigned q=0; q<numConsultas; q++)
+    {
+        Coord Or, De;
+        do
+        {
+            Or = livres[rand()%livres.size()];
+            De = livres[rand()%livres.size()];
+        }
+        while (Or == De);
+
+        ostringstream ss;
+        ss << descricao << " Or=" << Or << " De=" << De;
+        string contexto = ss.str();
+
+        vector<double> dist = distanciasReferencia(L, Or);
+        double ref = distanciaEm(L, dist, De);
+        vector<Coord> pontos;
+        int NC, NA, NF, alvo;
+        double c;
+
+        // Referencia do projeto
+        L.setOrigem(Or);
+        L.setDestino(De);
+        c = L.calculaCaminho(NC, NA, NF);
+        registra(O, C, REFERENCIA, confere(L, ref, c, L.getCaminho(), Or, De), contexto, ref, c);
+
+        // Suavizacao do caminho do A*: nunca mais longo
+        if (c >= 0.0)
+        {
+            c = L.suavizaCaminho();
+            registra(O, C, SUAVIZADO, c <= ref + EPS_VERIF && caminhoValido(L, L.getCaminho(), Or, De, c, true),
+                     contexto, ref, c);
+        }
+
+        // Qualquer angulo: nao sao garantidamente mais curtos que o A* (o Lazy Theta*, em
+        // particular, pode escolher um pai pior ao corrigir a linha de visada), mas nunca
+        // mais curtos que a reta entre Or e De
+        for (int lazy=0; lazy<2; lazy++)
+        {
+            ModoVerif M = (lazy ? LAZY_THETA : THETA);
+            c = L.calculaCaminhoTheta(NC, NA, NF, lazy == 1);
+            bool ok = (ref < 0.0 ? c < 0.0 :
+                       c >= norm(De-Or) - EPS_VERIF && caminhoValido(L, L.getCaminho(), Or, De, c, true));
+            registra(O, C, M, ok, contexto, ref, c);
+            if (ok && ref >= 0.0 && c > ref + EPS_VERIF) C.maisLongos[M]++;
+        }
+        L.limpaOrigDest();
+
+        c = L.buscaCaminho(Or, De, pontos, NA, NF, nullptr, &ctx);
+        registra(O, C, BUSCA, confere(L, ref, c, pontos, Or, De), contexto, ref, c);
+
+        c = L.buscaMaisProximo(vector<Coord>(1, Or), vector<Coord>(1, De), pontos, alvo, NA, NF, nullptr, &ctx);
+        registra(O, C, MAIS_PROXIMO, confere(L, ref, c, pontos, Or, De), contexto, ref, c);
+
+        c = L.buscaPreprocessada(Or, De, pontos);
+        registra(O, C, PREPROCESSADO, confere(L, ref, c, pontos, Or, De), contexto, ref, c);
+
+        c = B.distancia(Or, De);
+        registra(O, C, ONDA_DISTANCIA, (ref < 0.0 ? c < 0.0 : fabs(ref-c) < EPS_VERIF), contexto, ref, c);
+        bool alc = B.alcancavel(Or, De);
+        registra(O, C, ONDA_ALCANCAVEL, alc == (ref >= 0.0), contexto, ref, alc);
+
+        c = H.buscar(Or, De, pontos);
+        registra(O, C, HDA, confere(L, ref, c, pontos, Or, De), contexto, ref, c);
+
+        if (temArquivo)
+        {
+            Labirinto J;
+            c = J.buscaComJanela(arqVerif, Or, De, pontos, 1 + rand()%8);
+            registra(O, C, JANELA, confere(L, ref, c, pontos, Or, De), contexto, ref, c);
+        }
+
+        // Varias origens e varios destinos: alternadamente poucos (A*) e muitos (Dijkstra)
+        Coord Or2 = livres[rand()%livres.size()];
+        vector<double> dist2 = distanciasReferencia(L, Or2);
+        unsigned numAlvos = (q%2 == 0 ? 3 : MAX_ALVOS_HEURISTICA+4);
+        vector<Coord> destinos;
+        double refMulti = -1.0;
+        for (unsigned k=0; k<numAlvos; k++)
+        {
+            Coord D = livres[rand()%livres.size()];
+            destinos.push_back(D);
+            for (double d : {distanciaEm(L, dist, D), distanciaEm(L, dist2, D)})
+            {
+                if (d >= 0.0 && (refMulti < 0.0 || d < refMulti)) refMulti = d;
+            }
+        }
+        vector<Coord> origens = {Or, Or2};
+        ostringstream ss2;
+        ss2 << contexto << " Or2=" << Or2;
+        c = L.buscaMaisProximo(origens, destinos, pontos, alvo, NA, NF, nullptr, &ctx);
+        bool ok = (refMulti < 0.0 ? c < 0.0 :
+                   fabs(refMulti-c) < EPS_VERIF && alvo >= 0 &&
+                   (caminhoValido(L, pontos, Or, destinos[alvo], c, false) ||
+                    caminhoValido(L, pontos, Or2, destinos[alvo], c, false)));
+        registra(O, C, MULTIPLOS_ALVOS, ok, ss2.str(), refMulti, c);
+    }
+    if (temArquivo) remove(arqVerif.c_str());
+}
+
+/// Escreve o resumo das verificacoes e retorna true se nao houve falhas
+static bool resumo(ostream& O, const ContagemVerif& C, unsigned numMapas, double ms)
+{
+    unsigned long falhas = 0;
+    O << "VERIFICACAO: " << numMapas << " mapas em " << fixed << setprecision(1) << ms/1000 << "s" << endl;
+    for (int M=0; M<NUM_MODOS_VERIF; M++)
+    {
+        O << setw(18) << nomeModo[M] << ": " << setw(8) << C.testes[M] << " testes, "
+          << C.falhas[M] << " falhas";
+        if (C.maisLongos[M] > 0) O << " (" << C.maisLongos[M] << " mais longos que o A*)";
+        O << endl;
+        falhas += C.falhas[M];
+    }
+    O << (falhas == 0 ? "OK" : "FALHOU") << endl;
+    return falhas == 0;
+}
+
+/// Descricao de um mapa gerado, para reproducao
+static string descreveMapa(unsigned semente, unsigned numL, unsigned numC, double perc, LayoutMapa lay)
+{
+    ostringstream ss;
+    ss << "semente=" << semente << " mapa=" << numL << 'x' << numC << " obst=" << perc
+       << ' ' << layout2string(lay);
+    return ss.str();
+}
+
+/// Verifica numMapas mapas aleatorios
+bool verificaSolvers(ostream& O, unsigned numMapas, unsigned semente, unsigned dimMax,
+                     unsigned numConsultas)
+{
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    dimMax = max(dimMax, unsigned(LARGURA_MIN_MAPA));
+    ContagemVerif C;
+    for (unsigned m=0; m<numMapas; m++)
+    {
+        // Os parametros do mapa tambem sao tirados da semente
+        unsigned s = semente+m;
+        srand(s);
+        unsigned numL = ALTURA_MIN_MAPA + rand()%(dimMax-ALTURA_MIN_MAPA+1);
+        unsigned numC = LARGURA_MIN_MAPA + rand()%(dimMax-LARGURA_MIN_MAPA+1);
+        if (m%PERIODO_MAPA_LARGO == PERIODO_MAPA_LARGO-1) numC = LARGURA_MAPA_LARGO + rand()%64;
+        double perc = PERC_MIN_OBST + (PERC_MAX_OBST-PERC_MIN_OBST)*(rand()%1000)/1000.0;
+        LayoutMapa lay = LayoutMapa(rand()%3);
+
+        Labirinto L;
+        if (!L.gerar(numL, numC, perc, lay, s))
+        {
+            O << "Erro na geracao do mapa " << descreveMapa(s, numL, numC, perc, lay) << endl;
+            return false;
+        }
+        verificaMapa(O, L, descreveMapa(s, numL, numC, perc, lay), numConsultas, C);
+    }
+    using namespace chrono;
+    return resumo(O, C, numMapas, 1000*duration<double>(steady_clock::now() - t1).count());
+}
+
+/// Teste de longa duracao com mapas grandes
+bool soakSolvers(ostream& O, double segundos, unsigned dim, unsigned semente, unsigned numConsultas)
+{
+    using namespace chrono;
+    steady_clock::time_point t1 = steady_clock::now();
+    ContagemVerif C;
+    unsigned numMapas = 0;
+    while (numMapas == 0 || duration<double>(steady_clock::now() - t1).count() < segundos)
+    {
+        unsigned s = semente+numMapas;
+        srand(s);
+        double perc = PERC_MIN_OBST + (PERC_MAX_OBST-PERC_MIN_OBST)*(rand()%1000)/1000.0;
+        LayoutMapa lay = LayoutMapa(rand()%3);
+
+        Labirinto L;
+        if (!L.gerar(dim, dim, perc, lay, s))
+        {
+            O << "Erro na geracao do mapa " << descreveMapa(s, dim, dim, perc, lay) << endl;
+            return false;
+        }
+        verificaMapa(O, L, descreveMapa(s, dim, dim, perc, lay), numConsultas, C);
+        numMapas++;
+        O << "Mapa " << numMapas << " (semente " << s << ") verificado" << endl;
+    }
+    return resumo(O, C, numMapas, 1000*duration<double>(steady_clock::now() - t1).count());
+}
+
+/* ***************** */
+/* LIBFUZZER         */
+/* ***************** */
+
+#ifdef LABIRINTO_FUZZER
+/// Ponto de entrada do libFuzzer: os dados sao um arquivo de mapa (texto ou compacto)
+/// Os mapas aceitos devem ter dimensoes validas e sobreviver a ida e volta
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* dados, size_t tam)
+{
+    Labirinto L, M;
+
+    istringstream S(string((const char*)dados, tam));
+    if (L.ler(S))
+    {
+        stringstream T;
+        if (L.getNumLin() < ALTURA_MIN_MAPA || L.getNumLin() > Labirinto::getAlturaMax() ||
+                L.getNumCol() < LARGURA_MIN_MAPA || L.getNumCol() > Labirinto::getLarguraMax() ||
+                !L.salvar(T) || !M.ler(T) || !mesmosObstaculos(L, M))
+        {
+            abort();
+        }
+    }
+    else if (!L.empty()) abort();
+
+    if (L.lerCompacto(dados, tam))
+    {
+        vector<unsigned char> buf(L.tamanhoCompacto(FormatoCompacto::RLE));
+        if (L.escreverCompacto(FormatoCompacto::RLE, buf.data(), buf.size()) != buf.size() ||
+                !M.lerCompacto(buf.data(), buf.size()) || !mesmosObstaculos(L, M))
+        {
+            abort();
+        }
+    }
+    return 0;
+}
+#endif // LABIRINTO_FUZZER
@@ -0,0 +1,44 @@
+#ifndef _VERIFICACAO_H_
+#define _VERIFICACAO_H_
+
+#include <iostream>
+#include <string>
+#include "labirinto.h"
+
+/// Verificacao diferencial dos modos de resolucao
+/// Para cada mapa aleatorio (gerado por "gerar" com uma semente conhecida) e cada consulta
+/// sorteada, o comprimento de referencia eh calculado por um Dijkstra simples, independente
+/// do resto do codigo, e comparado com o de cada modo:
+/// - calculaCaminho (a referencia do projeto), buscaCaminho com contexto reusado;
+/// - buscaMaisProximo (um destino; varias origens e varios destinos, com A* e com Dijkstra);
+/// - hierarquia de contracao (buscaPreprocessada);
+/// - BuscaOnda (distancia e alcancavel), BuscaHDA (busca paralela);
+/// - buscaComJanela (leitura parcial de um arquivo temporario);
+/// - suavizaCaminho (nunca mais longo que a referencia);
+/// - Theta* e Lazy Theta* (nunca mais curtos que a reta; os mais longos que a referencia
+///   sao contados a parte, pois esses algoritmos nao garantem o contrario)
+/// Cada caminho retornado deve ir da origem ao destino, com movimentos validos
+/// (movimentoValido, ou linhaDeVisada nos modos de qualquer angulo) e com o comprimento
+/// informado. Tambem confere a ida e volta das codificacoes compactas e do formato texto
+/// Cada falha eh escrita em O com a semente e a consulta, para reproducao
+
+/// Verifica numMapas mapas (sementes semente, semente+1, ...) com dimensoes sorteadas
+/// entre as minimas e dimMax (e alguns mapas mais largos, com mais de 256 colunas) e
+/// numConsultas consultas por mapa
+/// Retorna true se nenhuma verificacao falhar
+bool verificaSolvers(std::ostream& O, unsigned numMapas, unsigned semente=1,
+                     unsigned dimMax=150, unsigned numConsultas=10);
+
+/// Teste de longa duracao: verifica mapas dim x dim (sementes semente, semente+1, ...)
+/// ate completar "segundos" segundos
+/// Retorna true se nenhuma verificacao falhar
+bool soakSolvers(std::ostream& O, double segundos, unsigned dim=1000, unsigned semente=1,
+                 unsigned numConsultas=5);
+
+/// Para o libFuzzer, compilar todos os arquivos com -DLABIRINTO_FUZZER (que retira o main
+/// do programa) e -fsanitize=fuzzer,address; por exemplo, com o clang:
+/// clang++ -std=c++11 -g -O1 -fsanitize=fuzzer,address -DLABIRINTO_FUZZER -pthread *.cpp -o fuzz_ler
+/// O ponto de entrada (LLVMFuzzerTestOneInput) passa os dados ao leitor do formato texto
+/// (ler) e ao da codificacao compacta (lerCompacto) e confere a ida e volta dos mapas aceitos
+
+#endif // _VERIFICACAO_H_
@@ -0,0 +1,132 @@
+#include <iomanip>
+#include <random>
+
+#include "versoes.h"
+#include "servico.h"
+
+using namespace std;
+
+/* ***************** */
+/* CLASSE EDICAO     */
+/* ***************** */
+
+Edicao::Edicao(): cel(), obstaculo(false) {}
+
+Edicao::Edicao(const Coord& C, bool obst): cel(C), obstaculo(obst) {}
+
+/* ******************* */
+/* CLASSE VERSOESMAPA  */
+/* ******************* */
+
+/// Cria as versoes a partir de uma copia do mapa M
+VersoesMapa::VersoesMapa(const Labirinto& M): corrente(), numVersao(0), editores()
+{
+    shared_ptr<Labirinto> prov = make_shared<Labirinto>(M);
+    prov->limpaOrigDest();
+    corrente = prov;
+}
+
+/// Retorna a versao corrente do mapa
+shared_ptr<const Labirinto> VersoesMapa::versao() const
+{
+    return atomic_load(&corrente);
+}
+
+/// Retorna o numero da versao corrente
+unsigned long VersoesMapa::getNumVersao() const
+{
+    return numVersao.load();
+}
+
+/// Aplica um lote de edicoes sobre uma copia da versao corrente e publica o resultado
+unsigned long VersoesMapa::editar(const vector<Edicao>& E)
+{
+    lock_guard<mutex> lock(editores);
+
+    // Copia na escrita: as consultas em andamento continuam com a versao anterior
+    // (a copia compartilha as paginas de celulas; setObstaculo duplica as que altera)
+    shared_ptr<Labirinto> nova = make_shared<Labirinto>(*atomic_load(&corrente));
+    for (const Edicao& Ed : E)
+    {
+        nova->setObstaculo(Ed.cel, Ed.obstaculo);
+    }
+
+    atomic_store(&corrente, shared_ptr<const Labirinto>(nova));
+    return ++numVersao;
+}
+
+/* ******************************* */
+/* GERADOR DE CARGA COM EDICOES    */
+/* ******************************* */
+
+/// Tempo decorrido desde t1, em milissegundos
+static double milissegundos(chrono::steady_clock::time_point t1)
+{
+    using namespace chrono;
+    duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
+    return 1000*time_span.count();
+}
+
+/// Gerador de carga com edicoes simultaneas
+void cargaComEdicoes(ostream& O, const Labirinto& M, unsigned numConsultas,
+                     unsigned numThreads, unsigned numLotes, unsigned tamLote)
+{
+    if (M.empty())
+    {
+        O << "Mapa vazio...\n";
+        return;
+    }
+
+    shared_ptr<VersoesMapa> V = make_shared<VersoesMapa>(M);
+    unsigned NL = M.getNumLin(), NC = M.getNumCol();
+
+    double tEdicoes = 0.0;
+    vector<Pedido> pedidos;
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    {
+        ServicoConsultas S(V, numThreads);
+
+        // Editor: coloca e retira obstaculos aleatoriamente
+        thread editor([&]
+        {
+            mt19937 gerador(12345);
+            chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+            for (unsigned k=0; k<numLotes; k++)
+            {
+                vector<Edicao> lote;
+                for (unsigned e=0; e<tamLote; e++)
+                {
+                    lote.push_back(Edicao(Coord(gerador()%NL, gerador()%NC), gerador()%2 == 0));
+                }
+                V->editar(lote);
+            }
+            tEdicoes = milissegundos(t2);
+        });
+
+        // Consultas entre celulas sorteadas (que podem ter virado obstaculos)
+        mt19937 gerador(1);
+        for (unsigned k=0; k<numConsultas; k++)
+        {
+            Coord Or(gerador()%NL, gerador()%NC), De(gerador()%NL, gerador()%NC);
+            pedidos.push_back(S.submeter(Consulta(Or, De)));
+        }
+
+        editor.join();
+        for (Pedido& P : pedidos) P.resposta.wait();
+    }
+    double tTotal = milissegundos(t1);
+
+    unsigned encontrados = 0;
+    for (Pedido& P : pedidos)
+    {
+        if (P.resposta.get().estado == EstadoResposta::ENCONTRADO) encontrados++;
+    }
+
+    O << "CARGA COM EDICOES " << numConsultas << " consultas, " << numThreads << " threads, "
+      << numLotes << " lotes de " << tamLote << " edicoes" << endl;
+    O << fixed << setprecision(3)
+      << "Tempo=" << tTotal << "ms\t Vazao=" << 1000.0*numConsultas/tTotal << " consultas/s"
+      << "\t Encontrados=" << encontrados << endl;
+    O << "Edicoes: " << V->getNumVersao() << " versoes em " << tEdicoes << "ms ("
+      << tEdicoes/max(numLotes, 1u) << "ms por versao)" << endl;
+}
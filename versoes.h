@@ -0,0 +1,64 @@
+#ifndef _VERSOES_H_
+#define _VERSOES_H_
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include "labirinto.h"
+
+/// Uma alteracao de obstaculo em uma celula do mapa
+struct Edicao
+{
+    Coord cel;
+    bool obstaculo;
+
+    Edicao();
+    Edicao(const Coord& C, bool obst);
+};
+
+/// Versoes imutaveis de um mapa (copia na escrita)
+/// As consultas obtem a versao corrente com "versao" e continuam usando essa versao ate o
+/// fim, mesmo que um editor publique versoes novas nesse meio tempo
+/// Cada edicao (ou lote de edicoes) gera uma copia da versao corrente, que recebe as
+/// alteracoes e depois eh publicada; uma versao antiga eh liberada quando a ultima
+/// consulta que a usa termina (contagem de referencias do shared_ptr)
+/// A copia compartilha com a versao anterior as paginas de celulas do mapa (ver Labirinto):
+/// somente as paginas com celulas editadas sao duplicadas
+/// A leitura da versao corrente nao espera pelas edicoes em andamento, somente pela troca do
+/// ponteiro na publicacao (atomic_load/atomic_store de shared_ptr, que na libstdc++ nao sao
+/// livres de bloqueio: usam um pequeno conjunto de mutexes); os editores sao serializados
+class VersoesMapa
+{
+private:
+    /// A versao corrente (lida e publicada com atomic_load/atomic_store)
+    shared_ptr<const Labirinto> corrente;
+    /// Numero da versao corrente (a versao inicial eh a 0)
+    atomic<unsigned long> numVersao;
+    /// Serializa os editores
+    mutex editores;
+
+public:
+    /// Cria as versoes a partir de uma copia do mapa M (versao 0)
+    /// A origem, o destino e o caminho de M nao fazem parte das versoes
+    explicit VersoesMapa(const Labirinto& M);
+
+    /// Retorna a versao corrente do mapa
+    shared_ptr<const Labirinto> versao() const;
+    /// Retorna o numero da versao corrente
+    unsigned long getNumVersao() const;
+
+    /// Aplica um lote de edicoes sobre uma copia da versao corrente e publica o resultado
+    /// O custo eh o da copia da tabela de paginas mais o das paginas editadas
+    /// As edicoes invalidas sao ignoradas
+    /// Retorna o numero da nova versao
+    unsigned long editar(const vector<Edicao>& E);
+};
+
+/// Gerador de carga com edicoes simultaneas
+/// numConsultas consultas aleatorias sao resolvidas por numThreads threads enquanto
+/// uma thread editora publica numLotes versoes, cada uma com tamLote edicoes aleatorias
+/// Escreve em O a vazao das consultas e das edicoes
+void cargaComEdicoes(std::ostream& O, const Labirinto& M, unsigned numConsultas,
+                     unsigned numThreads, unsigned numLotes=100, unsigned tamLote=16);
+
+#endif // _VERSOES_H_